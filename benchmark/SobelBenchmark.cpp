@@ -0,0 +1,563 @@
+/**
+ * @file benchmark/SobelBenchmark.cpp
+ *
+ * Microbenchmark of all public sobel functions. Every case is run on every instruction set the CPU supports and reports the median, minimum
+ * and 90th percentile time per frame, the cycles per pixel and the bytes per cycle. The cycles are those of the time stamp counter, which
+ * runs at the nominal frequency of the CPU. The bytes are those of the input image read by the kernel plus the results written.
+ *
+ * Usage: SobelBenchmark [--json] [--filter <text>] [--repetitions <n>] [--threads <n>] [--upper <file>] [--lower <file>]
+ *   --json         Prints one JSON object per case and instruction set instead of the table, for tracking the performance over time.
+ *   --filter       Only runs the cases whose name contains the text.
+ *   --repetitions  Number of measured runs per case, 50 by default. Every case is run 5 times before to warm up the caches.
+ *   --threads      Passed to SobelDortmund::setThreadCount, 1 by default.
+ *   --upper        Recorded YUV422 frame of the upper camera (1280x960, 2457600 bytes) instead of the synthetic one.
+ *   --lower        Recorded YUV422 frame of the lower camera (640x480, 614400 bytes) instead of the synthetic one.
+ *
+ * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
+ */
+
+#include "SobelDortmund.h"
+#include <x86intrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One benchmarked call of a sobel function.
+ */
+struct BenchmarkCase
+{
+  std::string name;
+  int pixels;                  ///< Number of calculated pixels.
+  double bytes;                ///< Bytes of the input image read plus bytes of the results written per call.
+  std::function<void()> run;
+};
+
+/**
+ * @brief Statistics of the measured runs of a case.
+ */
+struct BenchmarkResult
+{
+  double nsMedian;
+  double nsMin;
+  double nsP90;
+  double cyclesMedian;
+};
+
+static const char* instructionSetNames[] = { "SSSE3", "AVX2", "AVX512BW" };
+
+static const char* directionNames[] = { "Uni", "Horizontal", "Vertical" };
+
+/**
+ * @brief Creates a synthetic YUV422 frame looking roughly like a camera image of the field: a noisy green background with a few bright lines.
+ */
+static std::vector<unsigned char> syntheticFrame(int width, int height)
+{
+  std::vector<unsigned char> frame(2 * width * height);
+  unsigned int seed = 42;
+  for (int y = 0; y < height; ++y)
+  {
+    for (int x = 0; x < width; ++x)
+    {
+      seed = seed * 1103515245u + 12345u;
+      const int noise = static_cast<int>(seed >> 28);
+      const bool line = (x + y / 2) % 160 < 6 || y % 120 < 4;
+      frame[2 * (y * width + x)] = static_cast<unsigned char>((line ? 200 : 90) + noise);
+      frame[2 * (y * width + x) + 1] = static_cast<unsigned char>(x % 2 ? 110 : 100);
+    }
+  }
+  return frame;
+}
+
+/**
+ * @brief Reads a recorded YUV422 frame, exits if it does not have exactly the expected size.
+ */
+static std::vector<unsigned char> recordedFrame(const char* path, int width, int height)
+{
+  std::vector<unsigned char> frame(2 * width * height);
+  FILE* file = std::fopen(path, "rb");
+  if (!file || std::fread(frame.data(), 1, frame.size(), file) != frame.size())
+  {
+    std::fprintf(stderr, "Could not read %dx%d YUV422 frame from %s\n", width, height, path);
+    std::exit(1);
+  }
+  std::fclose(file);
+  return frame;
+}
+
+static BenchmarkResult measure(const BenchmarkCase& benchmarkCase, int repetitions)
+{
+  for (int i = 0; i < 5; ++i)
+  {
+    benchmarkCase.run();
+  }
+
+  std::vector<double> ns(repetitions);
+  std::vector<double> cycles(repetitions);
+  for (int i = 0; i < repetitions; ++i)
+  {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const unsigned long long startCycles = __rdtsc();
+    benchmarkCase.run();
+    const unsigned long long endCycles = __rdtsc();
+    ns[i] = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    cycles[i] = static_cast<double>(endCycles - startCycles);
+  }
+  std::sort(ns.begin(), ns.end());
+  std::sort(cycles.begin(), cycles.end());
+
+  BenchmarkResult result;
+  result.nsMedian = ns[repetitions / 2];
+  result.nsMin = ns[0];
+  result.nsP90 = ns[repetitions * 9 / 10];
+  result.cyclesMedian = cycles[repetitions / 2];
+  return result;
+}
+
+/**
+ * @brief Adds the cases of the functions taking any image, for a rectangle of the given size at the given offset of the image.
+ */
+static void addRectangleCases(std::vector<BenchmarkCase>& cases, const unsigned char* image, int width, int height, int offsetX, int offsetY,
+                              int rectangleWidth, int rectangleHeight, stdVector2D<unsigned char>& target)
+{
+  for (int quarter = 0; quarter < 2; ++quarter)
+  {
+    // The quarter functions take the size of the quarter image
+    const int w = quarter ? width / 2 : width;
+    const int h = quarter ? height / 2 : height;
+    const int startX = quarter ? offsetX / 2 : offsetX;
+    const int startY = quarter ? offsetY / 2 : offsetY;
+    const int endX = std::min(startX + (quarter ? rectangleWidth / 2 : rectangleWidth), w) - 1;
+    const int endY = std::min(startY + (quarter ? rectangleHeight / 2 : rectangleHeight), h) - 1;
+    const int pixels = (endX - startX + 1) * (endY - startY + 1);
+
+    for (int dir = 0; dir < 3; ++dir)
+    {
+      for (int returnFullArray = 0; returnFullArray < 2; ++returnFullArray)
+      {
+        char name[128];
+        std::snprintf(name, sizeof(name), "%s/%dx%d+%d+%d/%s/%s", quarter ? "Quarter" : "Full", endX - startX + 1, endY - startY + 1, startX, startY,
+                      directionNames[dir], returnFullArray ? "fullArray" : "rectangle");
+
+        // Full: 2 bytes per pixel read, quarter: 4 bytes (Y U Y V) per pixel read. The allocating version writes the whole array if requested.
+        const double bytes = pixels * (quarter ? 4.0 : 2.0) + (returnFullArray ? static_cast<double>(w) * h : pixels);
+        const SobelDortmund::Direction direction = static_cast<SobelDortmund::Direction>(dir);
+        const bool full = returnFullArray != 0;
+
+        BenchmarkCase allocating;
+        allocating.name = std::string("Any") + name;
+        allocating.pixels = pixels;
+        allocating.bytes = bytes;
+        allocating.run = [=]()
+        {
+          if (quarter)
+          {
+            SobelDortmund::sobelSSEAnyYUVImageQuarter(image, startX, startY, endX, endY, w, h, direction, full);
+          }
+          else
+          {
+            SobelDortmund::sobelSSEAnyYUVImageFull(image, startX, startY, endX, endY, w, h, direction, full);
+          }
+        };
+        cases.push_back(allocating);
+
+        BenchmarkCase view = allocating;
+        view.name = std::string("AnyView") + name;
+        stdVectorView2D<unsigned char> targetView = target.view();
+        view.run = [=]()
+        {
+          if (quarter)
+          {
+            SobelDortmund::sobelSSEAnyYUVImageQuarter(image, startX, startY, endX, endY, w, h, targetView, direction, full);
+          }
+          else
+          {
+            SobelDortmund::sobelSSEAnyYUVImageFull(image, startX, startY, endX, endY, w, h, targetView, direction, full);
+          }
+        };
+        cases.push_back(view);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Adds the cases of the overloads for the upper or lower camera.
+ */
+static void addCameraCases(std::vector<BenchmarkCase>& cases, const unsigned char* image, SobelDortmund::Camera camera,
+                           stdVector2D<unsigned char>& target)
+{
+  const SobelDortmund::CameraProfile& profile = SobelDortmund::getCameraProfile(camera);
+  const bool upper = camera == SobelDortmund::UpperCamera;
+  const std::string prefix = upper ? "Upper" : "Lower";
+  stdVectorView2D<unsigned char> targetView = target.view();
+
+  for (int dir = 0; dir < 3; ++dir)
+  {
+    const SobelDortmund::Direction direction = static_cast<SobelDortmund::Direction>(dir);
+    const std::string suffix = std::string("/") + directionNames[dir];
+    const int fullPixels = profile.width * profile.height;
+    const int quarterPixels = profile.quarterWidth * profile.quarterHeight;
+
+    BenchmarkCase c;
+    c.name = prefix + "Full" + suffix;
+    c.pixels = fullPixels;
+    c.bytes = 3.0 * fullPixels;
+    c.run = [=]() { upper ? SobelDortmund::sobelSSEImageUpperFull(image, direction) : SobelDortmund::sobelSSEImageLowerFull(image, direction); };
+    cases.push_back(c);
+
+    c.name = prefix + "FullView" + suffix;
+    c.run = [=]()
+    {
+      upper ? SobelDortmund::sobelSSEImageUpperFull(image, targetView, direction) : SobelDortmund::sobelSSEImageLowerFull(image, targetView, direction);
+    };
+    cases.push_back(c);
+
+    // A quarter of the image in the middle, as for a ball candidate
+    const int startX = profile.width / 4;
+    const int startY = profile.height / 4;
+    const int endX = startX + profile.width / 2 - 1;
+    const int endY = startY + profile.height / 2 - 1;
+    c.name = prefix + "FullRectangle" + suffix;
+    c.pixels = fullPixels / 4;
+    c.bytes = 3.0 * c.pixels;
+    c.run = [=]()
+    {
+      upper ? SobelDortmund::sobelSSEImageUpperFull(image, startX, startY, endX, endY, direction, false)
+            : SobelDortmund::sobelSSEImageLowerFull(image, startX, startY, endX, endY, direction, false);
+    };
+    cases.push_back(c);
+
+    c.name = prefix + "Quarter" + suffix;
+    c.pixels = quarterPixels;
+    c.bytes = 5.0 * quarterPixels;
+    c.run = [=]()
+    {
+      upper ? SobelDortmund::sobelSSEImageUpperQuarter(image, direction) : SobelDortmund::sobelSSEImageLowerQuarter(image, direction);
+    };
+    cases.push_back(c);
+
+    c.name = prefix + "QuarterView" + suffix;
+    c.run = [=]()
+    {
+      upper ? SobelDortmund::sobelSSEImageUpperQuarter(image, targetView, direction)
+            : SobelDortmund::sobelSSEImageLowerQuarter(image, targetView, direction);
+    };
+    cases.push_back(c);
+
+    c.name = prefix + "QuarterRectangle" + suffix;
+    c.pixels = quarterPixels / 4;
+    c.bytes = 5.0 * c.pixels;
+    c.run = [=]()
+    {
+      upper ? SobelDortmund::sobelSSEImageUpperQuarter(image, startX / 2, startY / 2, endX / 2, endY / 2, direction, false)
+            : SobelDortmund::sobelSSEImageLowerQuarter(image, startX / 2, startY / 2, endX / 2, endY / 2, direction, false);
+    };
+    cases.push_back(c);
+  }
+}
+
+/**
+ * @brief Adds one case per derived function (gradients, orientation, chroma, statistics, canny, the other operators, smoothing, scanlines,
+ * edge points, batch, pyramid, stream and incremental) on the whole image. The scanlines are calculated on the lower image, whose dense result is measured
+ * by LowerFullView.
+ */
+static void addFeatureCases(std::vector<BenchmarkCase>& cases, const unsigned char* image, int width, int height, const unsigned char* lowerImage)
+{
+  const int pixels = width * height;
+  const int endX = width - 1;
+  const int endY = height - 1;
+
+  // The buffers live as long as the cases
+  static stdVector2D<short> gx(width, height), gy(width, height);
+  static stdVector2D<unsigned char> magnitude(width, height), orientation(width, height), edges(width, height);
+  static stdVector2D<unsigned char> level1(width / 2, height / 2), level2(width / 4, height / 4), level3(width / 8, height / 8);
+  static stdVector2D<unsigned char> color(width / 2, height);
+  static std::vector<SobelDortmund::EdgePoint> points;
+  static std::vector<SobelDortmund::TileStatistics> statistics;
+  static SobelDortmund::BatchResult batch;
+  static SobelDortmund::ScanlineResult scanlines;
+  static SobelDortmund::Stream stream(width, height, magnitude.view());
+  static SobelDortmund::Incremental incremental(width, height);
+
+  BenchmarkCase c;
+  c.pixels = pixels;
+
+  c.name = "Gradients/Full";
+  c.bytes = 2.0 * pixels + 4.0 * pixels;
+  c.run = [=]() { SobelDortmund::sobelSSEAnyYUVImageGradientsFull(image, 0, 0, endX, endY, width, height, gx.view(), gy.view()); };
+  cases.push_back(c);
+
+  c.name = "Orientation/Full";
+  c.bytes = 2.0 * pixels + 2.0 * pixels;
+  c.run = [=]()
+  {
+    SobelDortmund::sobelSSEAnyYUVImageOrientationFull(image, 0, 0, endX, endY, width, height, magnitude.view(), orientation.view());
+  };
+  cases.push_back(c);
+
+  // The combined color edge strength has one value per pixel pair
+  c.name = "Chroma/Full/color";
+  c.bytes = 2.0 * pixels + pixels + pixels / 2;
+  c.run = [=]()
+  {
+    SobelDortmund::sobelSSEAnyYUVImageChromaFull(image, 0, 0, endX, endY, width, height, magnitude.view(), color.view());
+  };
+  cases.push_back(c);
+
+  c.name = "Statistics/Full/32";
+  c.bytes = 2.0 * pixels + pixels;
+  c.run = [=]()
+  {
+    SobelDortmund::sobelSSEAnyYUVImageStatisticsFull(image, 0, 0, endX, endY, width, height, magnitude.view(), statistics, 32, 60);
+  };
+  cases.push_back(c);
+
+  // The same statistics calculated by a scalar pass over the sobel result, to compare with the fused kernel
+  c.name = "Statistics/Full/32/separatePass";
+  c.bytes = 2.0 * pixels + 2.0 * pixels;
+  c.run = [=]()
+  {
+    SobelDortmund::sobelSSEAnyYUVImageFull(image, 0, 0, endX, endY, width, height, magnitude.view());
+    const int tilesX = (width + 31) / 32;
+    statistics.assign(tilesX * ((height + 31) / 32), SobelDortmund::TileStatistics());
+    for (int y = 1; y < endY; ++y)
+    {
+      for (int x = 1; x < endX; ++x)
+      {
+        const unsigned char value = magnitude(x, y);
+        SobelDortmund::TileStatistics& tile = statistics[(y / 32) * tilesX + x / 32];
+        ++tile.pixels;
+        tile.count += value >= 60;
+        tile.sum += value;
+        tile.max = std::max(tile.max, value);
+        ++tile.histogram[value / (256 / SobelDortmund::histogramBins)];
+      }
+    }
+  };
+  cases.push_back(c);
+
+  c.name = "Canny/Full";
+  c.bytes = 2.0 * pixels + pixels;
+  c.run = [=]() { SobelDortmund::sobelSSEAnyYUVImageCannyFull(image, 0, 0, endX, endY, width, height, edges.view(), 40, 100); };
+  cases.push_back(c);
+
+  c.name = "Scharr3x3/Full";
+  c.bytes = 2.0 * pixels + pixels;
+  c.run = [=]()
+  {
+    SobelDortmund::sobelSSEAnyYUVImageOperatorFull(image, 0, 0, endX, endY, width, height, magnitude.view(), SobelDortmund::Scharr3x3);
+  };
+  cases.push_back(c);
+
+  c.name = "Sobel5x5/Full";
+  c.run = [=]()
+  {
+    SobelDortmund::sobelSSEAnyYUVImageOperatorFull(image, 0, 0, endX, endY, width, height, magnitude.view(), SobelDortmund::Sobel5x5);
+  };
+  cases.push_back(c);
+
+  c.name = "Gaussian3x3/Full";
+  c.run = [=]()
+  {
+    SobelDortmund::sobelSSEAnyYUVImageSmoothedFull(image, 0, 0, endX, endY, width, height, magnitude.view(), SobelDortmund::Gaussian3x3);
+  };
+  cases.push_back(c);
+
+  c.name = "Gaussian5x5/Full";
+  c.run = [=]()
+  {
+    SobelDortmund::sobelSSEAnyYUVImageSmoothedFull(image, 0, 0, endX, endY, width, height, magnitude.view(), SobelDortmund::Gaussian5x5);
+  };
+  cases.push_back(c);
+
+  // Every 16th column of the lower image, as a scanline based field line detection would scan it
+  const SobelDortmund::CameraProfile& lower = SobelDortmund::getCameraProfile(SobelDortmund::LowerCamera);
+  std::vector<int> columns;
+  for (int x = 8; x < lower.width; x += 16)
+  {
+    columns.push_back(x);
+  }
+  c.name = "Scanlines/LowerFull/every16th";
+  c.pixels = static_cast<int>(columns.size()) * lower.height;
+  c.bytes = 2.0 * lower.width * lower.height + c.pixels;
+  c.run = [=]() { SobelDortmund::sobelSSEImageLowerFullScanlines(lowerImage, columns, std::vector<int>(), scanlines); };
+  cases.push_back(c);
+  c.pixels = pixels;
+
+  c.name = "EdgePoints/Full";
+  c.bytes = 2.0 * pixels;
+  c.run = [=]() { SobelDortmund::sobelSSEAnyYUVImageEdgePointsFull(image, 0, 0, endX, endY, width, height, points, 60, true); };
+  cases.push_back(c);
+
+  // 20 overlapping candidates of 96x96 pixels along a diagonal
+  std::vector<SobelDortmund::Rectangle> rectangles;
+  for (int i = 0; i < 20; ++i)
+  {
+    const int x = i * (width - 96) / 20;
+    const int y = i * (height - 96) / 20;
+    const SobelDortmund::Rectangle rectangle = { x, y, x + 95, y + 95 };
+    rectangles.push_back(rectangle);
+  }
+  c.name = "Batch/Full/20x96x96";
+  c.pixels = 20 * 96 * 96;
+  c.bytes = 3.0 * c.pixels;
+  c.run = [=]() { SobelDortmund::sobelSSEAnyYUVImageFullBatch(image, rectangles, width, height, batch); };
+  cases.push_back(c);
+
+  c.name = "Pyramid";
+  c.pixels = pixels / 4;
+  c.bytes = 2.0 * pixels + pixels / 4 + pixels / 16 + pixels / 64;
+  c.run = [=]() { SobelDortmund::sobelSSEAnyYUVImagePyramid(image, width, height, level1.view(), level2.view(), level3.view()); };
+  cases.push_back(c);
+
+  // The frame is pushed in chunks of 16 rows, as a camera driver would deliver it
+  c.name = "Stream/Full/16rows";
+  c.pixels = pixels;
+  c.bytes = 3.0 * pixels;
+  c.run = [=]()
+  {
+    stream.reset();
+    for (int y = 0; y < height; y += 16)
+    {
+      stream.push(image + 2 * y * width, std::min(16, height - y));
+    }
+  };
+  cases.push_back(c);
+
+  // Incremental updates with tiles of 32 pixels, first of an unchanged frame, then alternating with a frame differing in a block of 24x24
+  // pixels, which makes 4 tiles dirty
+  static std::vector<unsigned char> changed(image, image + 2 * pixels);
+  for (int y = 88; y < 112; ++y)
+  {
+    for (int x = 88; x < 112; ++x)
+    {
+      changed[2 * (y * width + x)] ^= 0x40;
+    }
+  }
+  c.name = "Incremental/Full/32/unchanged";
+  c.bytes = 2.0 * pixels;
+  c.run = [=]() { incremental.update(image); };
+  cases.push_back(c);
+
+  c.name = "Incremental/Full/32/block";
+  c.run = [=]()
+  {
+    static bool toggle = false;
+    toggle = !toggle;
+    incremental.update(toggle ? changed.data() : image);
+  };
+  cases.push_back(c);
+}
+
+int main(int argc, char** argv)
+{
+  bool json = false;
+  const char* filter = "";
+  int repetitions = 50;
+  int threads = 1;
+  const char* upperPath = nullptr;
+  const char* lowerPath = nullptr;
+  for (int i = 1; i < argc; ++i)
+  {
+    const bool hasValue = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--json"))
+    {
+      json = true;
+    }
+    else if (!std::strcmp(argv[i], "--filter") && hasValue)
+    {
+      filter = argv[++i];
+    }
+    else if (!std::strcmp(argv[i], "--repetitions") && hasValue)
+    {
+      repetitions = std::max(1, std::atoi(argv[++i]));
+    }
+    else if (!std::strcmp(argv[i], "--threads") && hasValue)
+    {
+      threads = std::atoi(argv[++i]);
+    }
+    else if (!std::strcmp(argv[i], "--upper") && hasValue)
+    {
+      upperPath = argv[++i];
+    }
+    else if (!std::strcmp(argv[i], "--lower") && hasValue)
+    {
+      lowerPath = argv[++i];
+    }
+    else
+    {
+      std::fprintf(stderr, "Usage: %s [--json] [--filter <text>] [--repetitions <n>] [--threads <n>] [--upper <file>] [--lower <file>]\n", argv[0]);
+      return 1;
+    }
+  }
+  SobelDortmund::setThreadCount(threads);
+
+  const SobelDortmund::CameraProfile& upperProfile = SobelDortmund::getCameraProfile(SobelDortmund::UpperCamera);
+  const SobelDortmund::CameraProfile& lowerProfile = SobelDortmund::getCameraProfile(SobelDortmund::LowerCamera);
+  const std::vector<unsigned char> upper = upperPath ? recordedFrame(upperPath, upperProfile.width, upperProfile.height)
+                                                     : syntheticFrame(upperProfile.width, upperProfile.height);
+  const std::vector<unsigned char> lower = lowerPath ? recordedFrame(lowerPath, lowerProfile.width, lowerProfile.height)
+                                                     : syntheticFrame(lowerProfile.width, lowerProfile.height);
+  stdVector2D<unsigned char> target(upperProfile.width, upperProfile.height);
+
+  std::vector<BenchmarkCase> cases;
+  addCameraCases(cases, upper.data(), SobelDortmund::UpperCamera, target);
+  addCameraCases(cases, lower.data(), SobelDortmund::LowerCamera, target);
+
+  // Rectangles from the whole image down to a small candidate, aligned and unaligned to the register width
+  const int sizes[][2] = { { 1280, 960 }, { 640, 480 }, { 160, 120 }, { 32, 32 } };
+  const int offsets[][2] = { { 0, 0 }, { 64, 64 }, { 13, 7 } };
+  for (const auto& size : sizes)
+  {
+    for (const auto& offset : offsets)
+    {
+      if (offset[0] + size[0] <= upperProfile.width && offset[1] + size[1] <= upperProfile.height)
+      {
+        addRectangleCases(cases, upper.data(), upperProfile.width, upperProfile.height, offset[0], offset[1], size[0], size[1], target);
+      }
+    }
+  }
+  addFeatureCases(cases, upper.data(), upperProfile.width, upperProfile.height, lower.data());
+
+  if (!json)
+  {
+    std::printf("%-48s %-9s %12s %12s %12s %10s %10s\n", "case", "isa", "median ns", "min ns", "p90 ns", "cyc/px", "B/cyc");
+  }
+  const SobelDortmund::InstructionSet detected = SobelDortmund::getInstructionSet();
+  for (int isa = SobelDortmund::SSSE3; isa <= detected; ++isa)
+  {
+    SobelDortmund::setInstructionSet(static_cast<SobelDortmund::InstructionSet>(isa));
+    for (const BenchmarkCase& benchmarkCase : cases)
+    {
+      if (benchmarkCase.name.find(filter) == std::string::npos)
+      {
+        continue;
+      }
+
+      const BenchmarkResult result = measure(benchmarkCase, repetitions);
+      const double cyclesPerPixel = result.cyclesMedian / benchmarkCase.pixels;
+      const double bytesPerCycle = benchmarkCase.bytes / result.cyclesMedian;
+      if (json)
+      {
+        std::printf("{\"case\":\"%s\",\"isa\":\"%s\",\"threads\":%d,\"repetitions\":%d,\"pixels\":%d,\"ns_median\":%.0f,\"ns_min\":%.0f,"
+                    "\"ns_p90\":%.0f,\"cycles_per_pixel\":%.4f,\"bytes_per_cycle\":%.4f}\n",
+                    benchmarkCase.name.c_str(), instructionSetNames[isa], SobelDortmund::getThreadCount(), repetitions, benchmarkCase.pixels,
+                    result.nsMedian, result.nsMin, result.nsP90, cyclesPerPixel, bytesPerCycle);
+      }
+      else
+      {
+        std::printf("%-48s %-9s %12.0f %12.0f %12.0f %10.3f %10.3f\n", benchmarkCase.name.c_str(), instructionSetNames[isa], result.nsMedian,
+                    result.nsMin, result.nsP90, cyclesPerPixel, bytesPerCycle);
+      }
+      std::fflush(stdout);
+    }
+  }
+  SobelDortmund::setInstructionSet(detected);
+  return 0;
+}
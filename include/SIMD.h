@@ -1,31 +1,29 @@
 /**
  * @file include/SIMD.h
  *
- * Declares some helper functions for SIMD intrinsics
+ * Declares some helper functions for SIMD intrinsics. They are not available if the library is compiled with SOBEL_PORTABLE.
  *
  * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
  */
 
 #pragma once
 
+#ifndef SOBEL_PORTABLE
+
 #include <tmmintrin.h>
+#include <cstring>
 
 /**
 * \brief Shifts each of the 16 8-bit integers in a bits right, shifting in zeroes.
-* This function is not available in SSE3, so it emulates the function by copying the register content to
-* two 16-Bit interpreted registers. _mm_srli_epi16 is then called on those two registers and the contents are wrote back
-* to one register.
+* This function is not available in SSE3, so it shifts the 16-bit integers instead and masks out the bits, which were shifted
+* in from the neighbouring 8-bit integer. That are two instructions instead of five for unpacking, shifting and packing again.
 * \param [in] a SSE Register containing 16 8-bit integers.
 * \param [in] bits Number of bits to shift the Register a.
 * \return The shifted register
 */
 inline __m128i _mm_srli_epi8(__m128i a, int bits)
 {
-  __m128i u = _mm_unpacklo_epi8(a, _mm_setzero_si128());
-  __m128i v = _mm_unpackhi_epi8(a, _mm_setzero_si128());
-  u = _mm_srli_epi16(u, bits);
-  v = _mm_srli_epi16(v, bits);
-  return _mm_packus_epi16(u, v);
+  return _mm_and_si128(_mm_srli_epi16(a, bits), _mm_set1_epi8(static_cast<char>(0xFF >> bits)));
 }
 
 /**
@@ -45,3 +43,20 @@ inline __m128i _mm_slli_epi8(__m128i a, int bits)
   v = _mm_slli_epi16(v, bits);
   return _mm_packus_epi16(u, v);
 }
+
+/**
+* \brief Stores only the first count of the 16 8-bit integers in a to unaligned memory.
+* SSE has no byte masked store besides the non-temporal _mm_maskmoveu_si128, which bypasses the cache. So the register
+* is spilled to an aligned buffer on the stack and only count bytes are copied, nothing behind mem_addr + count is written.
+* \param [out] mem_addr Destination, does not need to be aligned.
+* \param [in] a SSE Register containing 16 8-bit integers.
+* \param [in] count Number of bytes to store, has to be between 0 and 16.
+*/
+inline void _mm_maskstoreu_si128(void* mem_addr, __m128i a, int count)
+{
+  alignas(16) unsigned char buffer[16];
+  _mm_store_si128(reinterpret_cast<__m128i*>(buffer), a);
+  std::memcpy(mem_addr, buffer, count);
+}
+
+#endif
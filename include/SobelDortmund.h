@@ -20,10 +20,274 @@ class SobelDortmund
   };
 
   /**
-   * @brief Returns the sobel image for a YUV422 image using every Y value. Corner coordinates are interpreted as image coordinates, which
+   * @brief One pixel of the sparse result of sobelSSEAnyYUVImageEdgePointsFull.
+   */
+  struct EdgePoint
+  {
+    short x;                  ///< Column in image coordinates.
+    short y;                  ///< Row in image coordinates.
+    short gx;                 ///< Exact horizontal gradient as in sobelSSEAnyYUVImageGradientsFull, 0 if not requested.
+    short gy;                 ///< Exact vertical gradient as in sobelSSEAnyYUVImageGradientsFull, 0 if not requested.
+    unsigned char magnitude;  ///< The 8-bit sobel result.
+  };
+
+  // Number of bins of TileStatistics::histogram, each covering 256 / histogramBins sobel results
+  static const int histogramBins = 8;
+
+  /**
+   * @brief Statistics of the sobel results of one tile, see sobelSSEAnyYUVImageStatisticsFull.
+   */
+  struct TileStatistics
+  {
+    unsigned pixels;                     ///< Number of calculated pixels, i.e. those of the tile not at the border of the rectangle.
+    unsigned count;                      ///< Pixels with a result of at least the threshold.
+    unsigned sum;                        ///< Sum of the results.
+    unsigned char max;                   ///< Largest result, 0 without any pixel.
+    unsigned histogram[histogramBins];   ///< histogram[i] is the number of pixels with a result from 32 * i to 32 * i + 31.
+  };
+
+  /**
+   * @brief Cost of one public function since the last resetInstrumentation, see getInstrumentation.
+   */
+  struct EntryPointStatistics
+  {
+    const char* name;           ///< Name of the function, e.g. "sobelSSEAnyYUVImageQuarter" or "Stream::push".
+    unsigned long long calls;
+    unsigned long long pixels;  ///< Pixels of all calls in the (full or quarter) image, i.e. of the rectangles or the pushed rows.
+    double minMicroseconds;
+    double meanMicroseconds;
+    double p99Microseconds;     ///< 99th percentile, rounded up to the histogram of 8 buckets per octave, so at most 12% too high.
+    double cyclesPerPixel;      ///< Time stamp counter cycles per pixel of all calls, 0 where there is no time stamp counter.
+  };
+
+  /**
+   * @brief A rectangle in image coordinates. The corners can be given in any order like for the other sobel functions.
+   */
+  struct Rectangle
+  {
+    int startX;
+    int startY;
+    int endX;
+    int endY;
+  };
+
+  /**
+   * @brief Result of the batch functions, e.g. sobelSSEAnyYUVImageFullBatch. Keep one per caller and pass it again every frame, so its memory
+   * is only allocated once. Everything is replaced by the next call.
+   */
+  struct BatchResult
+  {
+    std::vector<stdVectorView2D<unsigned char>> views;  ///< The sobel result of every rectangle in the given order, each a view into the arena.
+    std::vector<Rectangle> regions;                      ///< The merged regions that were calculated, with top left start corners.
+    std::vector<unsigned char> arena;                    ///< The results of all regions, one after another without padding.
+  };
+
+  /**
+   * @brief Result of the scanline functions, e.g. sobelSSEAnyYUVImageFullScanlines. Keep one per caller and pass it again every frame, so its
+   * memory is only allocated once. Everything is replaced by the next call.
+   */
+  struct ScanlineResult
+  {
+    stdVectorView2D<unsigned char> columns;  ///< Row i is the result along the i-th column scanline, value y belonging to row y of the image.
+    stdVectorView2D<unsigned char> rows;     ///< Row i is the result along the i-th row scanline, value x belonging to column x of the image.
+    std::vector<unsigned char> arena;        ///< The results of all scanlines, one after another without padding.
+
+    ScanlineResult() : columns(nullptr, 0, 0), rows(nullptr, 0, 0) {}
+  };
+
+  /**
+   * @brief Layouts of the input image. Only the Y values are used by the sobel functions.
+   */
+  enum PixelFormat
+  {
+    YUYV,  ///< YUV422 as delivered by the cameras of the robot: Y0, U0, Y1, V0, ...
+    UYVY,  ///< YUV422 with the chroma first: U0, Y0, V0, Y1, ...
+    Y8     ///< A single 8-bit channel, e.g. a grayscale image or the Y plane of a planar image.
+  };
+
+  /**
+   * @brief How the quarter functions reduce the image to half its width and height.
+   */
+  enum QuarterSampling
+  {
+    Subsample,   ///< Every second Y value of every second row is used. This is the fastest, but aliases on fine textures.
+    BoxAverage   ///< Every Y value is the rounded average of a 2x2 block of the image.
+  };
+
+  /**
+   * @brief The image the sobel is calculated on. A plain pointer converts to a YUYV image without padding, so all sobel functions can be
+   * called with a camera image directly. The image is always read in place, other formats or padded rows are never copied.
+   */
+  struct InputImage
+  {
+    InputImage(const unsigned char* data, PixelFormat format = YUYV, int rowStride = 0, QuarterSampling quarterSampling = Subsample)
+      : data(data), format(format), rowStride(rowStride), quarterSampling(quarterSampling) {}
+
+    const unsigned char* data;        ///< The first byte of the first row.
+    PixelFormat format;
+    int rowStride;                    ///< Bytes between two rows of the full image, 0 if the rows are not padded (2 * width bytes for YUV422, width for Y8).
+    QuarterSampling quarterSampling;  ///< Only used by the quarter functions.
+  };
+
+  /**
+   * @brief How the sobel functions handle the border of the rectangle, where the 3x3 surrounding is not part of the rectangle.
+   */
+  enum BorderPolicy
+  {
+    BorderZero,       ///< The border of the rectangle and with returnFullArray everything outside of it is set to 0.
+    BorderReplicate,  ///< The border is calculated as well, using the image outside of the rectangle. Y values outside of the image are
+                      ///< replaced by the nearest one of the image. With returnFullArray everything outside of the rectangle is set to 0.
+    BorderMirror,     ///< Same as BorderReplicate, but Y values outside of the image are mirrored at its border (without repeating the border).
+    BorderUntouched   ///< Only the inner pixels of the rectangle are written, the border and everything outside of it are left as they are.
+  };
+
+  /**
+   * @brief The gradient operators of sobelSSEAnyYUVImageOperatorFull. All of them are calculated in 8 bit like the sobel operator, i.e. the
+   * weights are divided so that each side of a gradient is at most 255, and combined with the same magnitude approximation.
+   */
+  enum Operator
+  {
+    Sobel3x3,   ///< The sobel operator of all other functions, weights 1, 2, 1.
+    Scharr3x3,  ///< Scharr operator with the weights 3, 10, 3, which is closer to rotation invariant. Each side is divided by 16.
+    Sobel5x5    ///< 5x5 sobel operator, the binomial smoothing 1, 4, 6, 4, 1 across the derivative 1, 2, 0, -2, -1. Less sensitive to noise,
+                ///< but each side is at most 191 and the border of the rectangle is 2 pixels wide.
+  };
+
+  /**
+   * @brief The gaussian the Y values are smoothed with before the sobel operator, see sobelSSEAnyYUVImageSmoothedFull. The binomial weights
+   * are divided like those of the operators, i.e. rounded down per value.
+   */
+  enum Smoothing
+  {
+    NoSmoothing,  ///< The same as sobelSSEAnyYUVImageFull with BorderZero.
+    Gaussian3x3,  ///< Weights 1, 2, 1 in both directions, the border of the rectangle is 2 pixels wide.
+    Gaussian5x5   ///< Weights 1, 4, 6, 4, 1 in both directions, the border of the rectangle is 3 pixels wide.
+  };
+
+  /**
+   * @brief Instruction sets the kernels are available for. Ordered from the narrowest to the widest.
+   */
+  enum InstructionSet
+  {
+    SSSE3,    ///< 128-bit, 16 results per iteration. Always available, if compiled with SOBEL_PORTABLE these are the portable kernels.
+    AVX2,     ///< 256-bit, 32 results per iteration.
+    AVX512BW  ///< 512-bit, 64 results per iteration.
+  };
+
+  /**
+   * @brief The cameras of the robot, whose images are taken by the sobelSSEImageUpper* and sobelSSEImageLower* functions.
+   */
+  enum Camera
+  {
+    UpperCamera,
+    LowerCamera
+  };
+
+  /**
+   * @brief Image geometry of a camera. The row stride and the last column and row of the full and quarter image are calculated once when the
+   * profile is set, the functions for the camera pass them on instead of deriving them from the size on every call.
+   */
+  struct CameraProfile
+  {
+    int width;          ///< Width of the full image.
+    int height;         ///< Height of the full image.
+    int quarterWidth;   ///< Width of the quarter image, i.e. every second Y value.
+    int quarterHeight;  ///< Height of the quarter image, i.e. every second row.
+    int rowStride;      ///< Bytes between two rows of the YUV422 image, the quarter functions step over 2 * rowStride bytes.
+    int lastX;          ///< Last column of the full image, the end corner of the whole image.
+    int lastY;          ///< Last row of the full image.
+    int quarterLastX;   ///< Last column of the quarter image.
+    int quarterLastY;   ///< Last row of the quarter image.
+
+    /**
+     * @brief The image of this camera with the precomputed row stride.
+     */
+    InputImage input(const unsigned char* data) const
+    {
+      return InputImage(data, YUYV, rowStride);
+    }
+  };
+
+  /**
+   * @brief Sets the image size of a camera, which is used by the sobelSSEImageUpper* or sobelSSEImageLower* functions from now on. So the
+   * resolution can be switched at runtime, e.g. to calculate less while walking. Like setInstructionSet this should not be called while any
+   * sobel function is running for that camera.
+   * @param [in] camera The camera.
+   * @param [in] width Width of the full image.
+   * @param [in] height Height of the full image.
+   */
+  static void setCameraProfile(Camera camera, int width, int height);
+
+  /**
+   * @brief Returns the current image geometry of a camera.
+   * @param [in] camera The camera.
+   * @return The geometry set by setCameraProfile or the default one.
+   */
+  static const CameraProfile& getCameraProfile(Camera camera)
+  {
+    return cameraProfiles[camera];
+  }
+
+  /**
+   * @brief Returns the instruction set the kernels are currently using. It is detected from CPUID on first use and is the widest
+   * one supported by the CPU, so the same library runs on the robot and uses the wider kernels on a PC.
+   * Only the sobel functions (sobelSSEAnyYUVImageFull, sobelSSEAnyYUVImageQuarter and their camera and batch versions), the Operator, Smoothed
+   * and Scanlines functions, Stream and the recalculation of Incremental follow it. The Gradients, Orientation, Chroma, Statistics, Canny and
+   * EdgePoints functions, the pyramid and the change detection of Incremental always use the SSSE3 kernels (the portable ones with
+   * SOBEL_PORTABLE).
+   * @return The active instruction set.
+   */
+  static InstructionSet getInstructionSet();
+
+  /**
+   * @brief Overrides the detected instruction set, for example to compare the kernels. This is not thread safe, so it should be called
+   * before any sobel function is running. It has no effect on the functions that always use the SSSE3 kernels, see getInstructionSet.
+   * @param [in] instructionSet The instruction set to use.
+   * @return False if the CPU does not support the instruction set. The active one is not changed then.
+   */
+  static bool setInstructionSet(InstructionSet instructionSet);
+
+  /**
+   * @brief Sets the number of threads used by the sobel functions. The rows of the rectangle are split into horizontal bands, which are
+   * calculated in parallel by a persistent pool of worker threads, so no threads are spawned per call. The calling thread works on a band as
+   * well. Like setInstructionSet this should not be called while any sobel function is running.
+   * @param [in] threads Number of threads including the calling one. 1 is the default and calculates everything on the calling thread,
+   * 0 or less uses the hardware concurrency.
+   */
+  static void setThreadCount(int threads);
+
+  /**
+   * @brief Returns the number of threads used by the sobel functions.
+   * @return The number of threads including the calling one.
+   */
+  static int getThreadCount();
+
+  /**
+   * @brief Returns whether the library was compiled with SOBEL_INSTRUMENTATION. Only then the public functions record their calls, pixels and
+   * durations (a few atomic additions and two clock reads per call). Otherwise nothing is recorded at all and the snapshot is always empty.
+   * @return True if the calls are recorded.
+   */
+  static bool isInstrumented();
+
+  /**
+   * @brief Copies the statistics of every public function called since the last reset, in the order they were called first. Can be called
+   * while sobel functions are running on other threads, e.g. by the debug tooling once per frame, their current calls might be counted
+   * partially then. Functions returning a new stdVector2D are counted as the function writing into a view they call, and the overloads for
+   * the upper and lower camera as the function they call.
+   * @param [out] snapshot The statistics, empty without SOBEL_INSTRUMENTATION.
+   */
+  static void getInstrumentation(std::vector<EntryPointStatistics>& snapshot);
+
+  /**
+   * @brief Sets all recorded statistics back to zero.
+   */
+  static void resetInstrumentation();
+
+  /**
+   * @brief Returns the sobel image for an image using every Y value. Corner coordinates are interpreted as image coordinates, which
    * means that if you have a full size image of 1280 by 960, the full size rectangle is defined by (0,0) to (1279, 959) !
    * Start and end corners can be either top left and bottom right or top right and bottom left in any order.
-   * @param [in] YUVImage The YUV422 image on which the sobel is calculated.
+   * @param [in] YUVImage The image on which the sobel is calculated.
    * @param [in] startX Start corner in image coordinates, i.e. starting at 0 and ending at width - 1.
    * @param [in] startY Start corner in image coordinates, i.e. starting at 0 and ending at width - 1.
    * @param [in] endX End corner in image coordinates, i.e. starting at 0 and ending at width - 1.
@@ -33,10 +297,22 @@ class SobelDortmund
    * @param [in] dir If you want the normal sobel in both horizontal and vertical directions or only one of them. Both (=Uni) is the standard value.
    * @param [in] returnFullArray If you want a full size result even if the defined rectangle is smaller than the full image. Everything outside the
    * rectangle is filled black. Otherwise the result is the size of the rectangle.
+   * @param [in] border How the border of the rectangle is handled, see BorderPolicy. Only the affected rows and columns are written.
    * @return The sobel result.
    */
-  static const stdVector2D<unsigned char> sobelSSEAnyYUVImageFull(const unsigned char* YUVImage, int startX, int startY, int endX, int endY, int width, int height,
-                                                            Direction dir = Uni, bool returnFullArray = true);
+  static const stdVector2D<unsigned char> sobelSSEAnyYUVImageFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                            Direction dir = Uni, bool returnFullArray = true, BorderPolicy border = BorderZero);
+
+  /**
+   * @brief Same as the allocating version, but writes the sobel result into a caller owned buffer. No memory is allocated.
+   * With returnFullArray the target has to be at least width by height, otherwise at least the size of the rectangle. The last store of each
+   * row is masked, so nothing right of the rectangle (or the target row) is written.
+   * @param [out] target View on the caller owned result buffer, rows may be padded (stride >= width).
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEAnyYUVImageFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                      stdVectorView2D<unsigned char> target, Direction dir = Uni, bool returnFullArray = true,
+                                      BorderPolicy border = BorderZero);
 
   /**
    * @brief Overloaded function taking the robots upper image instead of any image. A rectangle may be defined.
@@ -45,7 +321,7 @@ class SobelDortmund
   static const stdVector2D<unsigned char> sobelSSEImageUpperFull(const unsigned char* imageUpper, int startX, int startY, int endX, int endY, Direction dir = Uni,
                                                            bool returnFullArray = true)
   {
-    return sobelSSEAnyYUVImageFull(imageUpper, startX, startY, endX, endY, IMAGE_UPPER_FULL_WIDTH, IMAGE_UPPER_FULL_HEIGHT, dir, returnFullArray);
+    return sobelSSEAnyYUVImageFull(cameraProfiles[UpperCamera].input(imageUpper), startX, startY, endX, endY, cameraProfiles[UpperCamera].width, cameraProfiles[UpperCamera].height, dir, returnFullArray);
   }
 
   /**
@@ -55,7 +331,7 @@ class SobelDortmund
   static const stdVector2D<unsigned char> sobelSSEImageLowerFull(const unsigned char* imageLower, int startX, int startY, int endX, int endY, Direction dir = Uni,
                                                            bool returnFullArray = true)
   {
-    return sobelSSEAnyYUVImageFull(imageLower, startX, startY, endX, endY, IMAGE_LOWER_FULL_WIDTH, IMAGE_LOWER_FULL_HEIGHT, dir, returnFullArray);
+    return sobelSSEAnyYUVImageFull(cameraProfiles[LowerCamera].input(imageLower), startX, startY, endX, endY, cameraProfiles[LowerCamera].width, cameraProfiles[LowerCamera].height, dir, returnFullArray);
   }
 
   /**
@@ -67,10 +343,10 @@ class SobelDortmund
   {    
     int startX = 0;
     int startY = 0;
-    int endX = IMAGE_UPPER_FULL_WIDTH - 1;
-    int endY = IMAGE_UPPER_FULL_HEIGHT - 1;
+    int endX = cameraProfiles[UpperCamera].lastX;
+    int endY = cameraProfiles[UpperCamera].lastY;
 
-    return sobelSSEAnyYUVImageFull(imageUpper, startX, startY, endX, endY, IMAGE_UPPER_FULL_WIDTH, IMAGE_UPPER_FULL_HEIGHT, dir, true);
+    return sobelSSEAnyYUVImageFull(cameraProfiles[UpperCamera].input(imageUpper), startX, startY, endX, endY, cameraProfiles[UpperCamera].width, cameraProfiles[UpperCamera].height, dir, true);
   }
 
   /**
@@ -82,18 +358,40 @@ class SobelDortmund
   {    
     int startX = 0;
     int startY = 0;
-    int endX = IMAGE_LOWER_FULL_WIDTH - 1;
-    int endY = IMAGE_LOWER_FULL_HEIGHT - 1;
+    int endX = cameraProfiles[LowerCamera].lastX;
+    int endY = cameraProfiles[LowerCamera].lastY;
+
+    return sobelSSEAnyYUVImageFull(cameraProfiles[LowerCamera].input(imageLower), startX, startY, endX, endY, cameraProfiles[LowerCamera].width, cameraProfiles[LowerCamera].height, dir, true);
+  }
+
+  /**
+   * @brief Overloaded function taking the robots upper image and writing the sobel result of the whole image into a caller owned buffer of
+   * at least the full upper image size.
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEImageUpperFull(const unsigned char* imageUpper, stdVectorView2D<unsigned char> target, Direction dir = Uni)
+  {
+    sobelSSEAnyYUVImageFull(cameraProfiles[UpperCamera].input(imageUpper), 0, 0, cameraProfiles[UpperCamera].lastX, cameraProfiles[UpperCamera].lastY, cameraProfiles[UpperCamera].width, cameraProfiles[UpperCamera].height,
+                            target, dir, true);
+  }
 
-    return sobelSSEAnyYUVImageFull(imageLower, startX, startY, endX, endY, IMAGE_LOWER_FULL_WIDTH, IMAGE_LOWER_FULL_HEIGHT, dir, true);
+  /**
+   * @brief Overloaded function taking the robots lower image and writing the sobel result of the whole image into a caller owned buffer of
+   * at least the full lower image size.
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEImageLowerFull(const unsigned char* imageLower, stdVectorView2D<unsigned char> target, Direction dir = Uni)
+  {
+    sobelSSEAnyYUVImageFull(cameraProfiles[LowerCamera].input(imageLower), 0, 0, cameraProfiles[LowerCamera].lastX, cameraProfiles[LowerCamera].lastY, cameraProfiles[LowerCamera].width, cameraProfiles[LowerCamera].height,
+                            target, dir, true);
   }
 
   /**
-   * @brief Returns the sobel image for a YUV422 image using every second Y value and every second row. Corner coordinates are interpreted as image
+   * @brief Returns the sobel image for an image using every second Y value and every second row. Corner coordinates are interpreted as image
    * coordinates, which
    * means that if you have a quarter size image of 640 by 480, the full size rectangle is defined by (0,0) to (639, 479) !
    * Start and end corners can be either top left and bottom right or top right and bottom left in any order.
-   * @param [in] YUVImage The YUV422 image on which the sobel is calculated.
+   * @param [in] YUVImage The image on which the sobel is calculated.
    * @param [in] startX Start corner in image coordinates, i.e. starting at 0 and ending at width - 1.
    * @param [in] startY Start corner in image coordinates, i.e. starting at 0 and ending at width - 1.
    * @param [in] endX End corner in image coordinates, i.e. starting at 0 and ending at width - 1.
@@ -103,10 +401,22 @@ class SobelDortmund
    * @param [in] dir If you want the normal sobel in both horizontal and vertical directions or only one of them. Both is standard value.
    * @param [in] returnFullArray If you want a full size result even if the defined rectangle is smaller than the full image. Everything outside the
    * rectangle is filled black. Otherwise the result is the size of the rectangle.
+   * @param [in] border How the border of the rectangle is handled, see BorderPolicy. Only the affected rows and columns are written.
    * @return The sobel result.
    */
-  static const stdVector2D<unsigned char> sobelSSEAnyYUVImageQuarter(const unsigned char* YUVImage, int startX, int startY, int endX, int endY, int width, int height,
-                                                               Direction dir = Uni, bool returnFullArray = true);
+  static const stdVector2D<unsigned char> sobelSSEAnyYUVImageQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                               Direction dir = Uni, bool returnFullArray = true, BorderPolicy border = BorderZero);
+
+  /**
+   * @brief Same as the allocating version, but writes the sobel result into a caller owned buffer. No memory is allocated.
+   * With returnFullArray the target has to be at least width by height of the quarter image, otherwise at least the size of the rectangle.
+   * The last store of each row is masked, so nothing right of the rectangle (or the target row) is written.
+   * @param [out] target View on the caller owned result buffer, rows may be padded (stride >= width).
+   * @see sobelSSEAnyYUVImageQuarter
+   */
+  static void sobelSSEAnyYUVImageQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                         stdVectorView2D<unsigned char> target, Direction dir = Uni, bool returnFullArray = true,
+                                         BorderPolicy border = BorderZero);
 
   /**
    * @brief Overloaded function taking the robots upper image instead of any image. A rectangle and a direction may be defined.
@@ -115,7 +425,7 @@ class SobelDortmund
   static const stdVector2D<unsigned char> sobelSSEImageUpperQuarter(const unsigned char* imageUpper, int startX, int startY, int endX, int endY, Direction dir = Uni,
                                                               bool returnFullArray = true)
   {
-    return sobelSSEAnyYUVImageQuarter(imageUpper, startX, startY, endX, endY, IMAGE_UPPER_FULL_WIDTH / 2, IMAGE_UPPER_FULL_HEIGHT / 2, dir, returnFullArray);
+    return sobelSSEAnyYUVImageQuarter(cameraProfiles[UpperCamera].input(imageUpper), startX, startY, endX, endY, cameraProfiles[UpperCamera].quarterWidth, cameraProfiles[UpperCamera].quarterHeight, dir, returnFullArray);
   }
 
   /**
@@ -127,10 +437,10 @@ class SobelDortmund
   {
     int startX = 0;
     int startY = 0;
-    int endX = IMAGE_UPPER_FULL_WIDTH / 2 - 1;
-    int endY = IMAGE_UPPER_FULL_HEIGHT / 2 - 1;
+    int endX = cameraProfiles[UpperCamera].quarterLastX;
+    int endY = cameraProfiles[UpperCamera].quarterLastY;
 
-    return sobelSSEAnyYUVImageQuarter(imageUpper, startX, startY, endX, endY, IMAGE_UPPER_FULL_WIDTH / 2, IMAGE_UPPER_FULL_HEIGHT / 2, dir, true);
+    return sobelSSEAnyYUVImageQuarter(cameraProfiles[UpperCamera].input(imageUpper), startX, startY, endX, endY, cameraProfiles[UpperCamera].quarterWidth, cameraProfiles[UpperCamera].quarterHeight, dir, true);
   }
 
 
@@ -141,7 +451,7 @@ class SobelDortmund
   static const stdVector2D<unsigned char> sobelSSEImageLowerQuarter(const unsigned char* imageLower, int startX, int startY, int endX, int endY, Direction dir = Uni,
                                                               bool returnFullArray = true)
   {
-    return sobelSSEAnyYUVImageQuarter(imageLower, startX, startY, endX, endY, IMAGE_LOWER_FULL_WIDTH / 2, IMAGE_LOWER_FULL_HEIGHT / 2, dir, returnFullArray);
+    return sobelSSEAnyYUVImageQuarter(cameraProfiles[LowerCamera].input(imageLower), startX, startY, endX, endY, cameraProfiles[LowerCamera].quarterWidth, cameraProfiles[LowerCamera].quarterHeight, dir, returnFullArray);
   }
 
   /**
@@ -154,21 +464,520 @@ class SobelDortmund
 
     int startX = 0;
     int startY = 0;
-    int endX = IMAGE_LOWER_FULL_WIDTH / 2 - 1;
-    int endY = IMAGE_LOWER_FULL_HEIGHT / 2 - 1;
-    return sobelSSEAnyYUVImageQuarter(imageLower, startX, startY, endX, endY, IMAGE_LOWER_FULL_WIDTH / 2, IMAGE_LOWER_FULL_HEIGHT / 2, dir, true);
+    int endX = cameraProfiles[LowerCamera].quarterLastX;
+    int endY = cameraProfiles[LowerCamera].quarterLastY;
+    return sobelSSEAnyYUVImageQuarter(cameraProfiles[LowerCamera].input(imageLower), startX, startY, endX, endY, cameraProfiles[LowerCamera].quarterWidth, cameraProfiles[LowerCamera].quarterHeight, dir, true);
   }
 
 
+  /**
+   * @brief Overloaded function taking the robots upper image and writing the quarter sobel result of the whole image into a caller owned
+   * buffer of at least the quarter upper image size.
+   * @see sobelSSEAnyYUVImageQuarter
+   */
+  static void sobelSSEImageUpperQuarter(const unsigned char* imageUpper, stdVectorView2D<unsigned char> target, Direction dir = Uni)
+  {
+    sobelSSEAnyYUVImageQuarter(cameraProfiles[UpperCamera].input(imageUpper), 0, 0, cameraProfiles[UpperCamera].quarterLastX, cameraProfiles[UpperCamera].quarterLastY, cameraProfiles[UpperCamera].quarterWidth,
+                               cameraProfiles[UpperCamera].quarterHeight, target, dir, true);
+  }
+
+  /**
+   * @brief Overloaded function taking the robots lower image and writing the quarter sobel result of the whole image into a caller owned
+   * buffer of at least the quarter lower image size.
+   * @see sobelSSEAnyYUVImageQuarter
+   */
+  static void sobelSSEImageLowerQuarter(const unsigned char* imageLower, stdVectorView2D<unsigned char> target, Direction dir = Uni)
+  {
+    sobelSSEAnyYUVImageQuarter(cameraProfiles[LowerCamera].input(imageLower), 0, 0, cameraProfiles[LowerCamera].quarterLastX, cameraProfiles[LowerCamera].quarterLastY, cameraProfiles[LowerCamera].quarterWidth,
+                               cameraProfiles[LowerCamera].quarterHeight, target, dir, true);
+  }
+
+
+  /**
+   * @brief Calculates the exact signed sobel gradients of an image using every Y value. Unlike the 8-bit result nothing is divided
+   * or saturated, so no precision and no sign is lost. gx is positive where the image gets brighter to the right and gy where it gets
+   * brighter downwards, both are between -1020 and 1020. Both are calculated in the same pass.
+   * The border of the rectangle and with returnFullArray everything outside of it is set to 0. No memory is allocated.
+   * @param [in] YUVImage The image on which the gradients are calculated.
+   * @param [in] startX Start corner in image coordinates, i.e. starting at 0 and ending at width - 1.
+   * @param [in] startY Start corner in image coordinates, i.e. starting at 0 and ending at height - 1.
+   * @param [in] endX End corner in image coordinates, i.e. starting at 0 and ending at width - 1.
+   * @param [in] endY End corner in image coordinates, i.e. starting at 0 and ending at height - 1.
+   * @param [in] width Width of the image.
+   * @param [in] height Height of the image.
+   * @param [out] gx Caller owned buffer for the horizontal gradients. With returnFullArray it has to be at least width by height, otherwise
+   * at least the size of the rectangle.
+   * @param [out] gy Caller owned buffer for the vertical gradients, same size as gx.
+   * @param [in] returnFullArray If the results are stored at image coordinates or relative to the rectangle.
+   */
+  static void sobelSSEAnyYUVImageGradientsFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                               stdVectorView2D<short> gx, stdVectorView2D<short> gy, bool returnFullArray = true);
+
+  /**
+   * @brief Same as above, but gx and gy are stored interleaved into one buffer, i.e. gx of pixel (x,y) at (2 * x, y) and gy at (2 * x + 1, y).
+   * So the buffer has to be twice as wide.
+   * @see sobelSSEAnyYUVImageGradientsFull
+   */
+  static void sobelSSEAnyYUVImageGradientsFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                               stdVectorView2D<short> gxy, bool returnFullArray = true);
+
+  /**
+   * @brief Calculates the exact signed sobel gradients of an image using every second Y value and every second row, i.e. on the
+   * quarter image. Coordinates, width and height are those of the quarter image.
+   * @see sobelSSEAnyYUVImageGradientsFull
+   */
+  static void sobelSSEAnyYUVImageGradientsQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                  stdVectorView2D<short> gx, stdVectorView2D<short> gy, bool returnFullArray = true);
+
+  /**
+   * @brief Same as above, but gx and gy are stored interleaved into one buffer of twice the width.
+   * @see sobelSSEAnyYUVImageGradientsFull
+   */
+  static void sobelSSEAnyYUVImageGradientsQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                  stdVectorView2D<short> gxy, bool returnFullArray = true);
+
+  /**
+   * @brief Calculates the sobel image like sobelSSEAnyYUVImageFull and in the same pass the orientation of the gradient, quantized into 8 bins.
+   * Bin b is the direction b * 45 degrees (+-22.5 degrees), counting clockwise from the right in image coordinates, i.e. 0 means the image gets
+   * brighter to the right, 2 downwards, 4 to the left and 6 upwards. Opposite directions differ by 4, so bin & 3 is the orientation of the edge
+   * without its polarity (0 for a vertical edge, 2 for a horizontal one, 1 and 3 for the diagonals). Pixels without a gradient get bin 0.
+   * The border of the rectangle and with returnFullArray everything outside of it is set to 0 in both targets. No memory is allocated.
+   * @param [out] magnitude Caller owned buffer for the sobel result. With returnFullArray it has to be at least width by height, otherwise
+   * at least the size of the rectangle.
+   * @param [out] orientation Caller owned buffer for the orientation bins, same size as magnitude.
+   * @param [in] dir Direction of the sobel result, the orientation always uses both gradients.
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEAnyYUVImageOrientationFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                 stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> orientation,
+                                                 Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Same as sobelSSEAnyYUVImageOrientationFull on the quarter image, i.e. using every second Y value and every second row.
+   * @see sobelSSEAnyYUVImageOrientationFull
+   */
+  static void sobelSSEAnyYUVImageOrientationQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                    stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> orientation,
+                                                    Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Calculates the sobel image like sobelSSEAnyYUVImageFull and in the same pass the sobel results of the U and V values, so the image
+   * is read only once. The chroma results have half the horizontal resolution, i.e. chroma column c belongs to the pixel pair 2 * c and 2 * c + 1
+   * sharing its U and V values. Their rectangle is the one of the pairs of the corners, (startX / 2, startY) to (endX / 2, endY), cut to the
+   * width / 2 complete pairs of the image. A Y8 image has no chroma, so all its chroma results are 0.
+   * The border of both rectangles and with returnFullArray everything outside of them is set to 0. No memory is allocated.
+   * @param [out] magnitude Caller owned buffer for the sobel result of the Y values. With returnFullArray it has to be at least width by height,
+   * otherwise at least the size of the rectangle.
+   * @param [out] u Caller owned buffer for the sobel result of the U values. With returnFullArray it has to be at least width / 2 by height,
+   * otherwise at least the size of the chroma rectangle.
+   * @param [out] v Caller owned buffer for the sobel result of the V values, same size as u.
+   * @param [in] dir Direction of all three sobel results.
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEAnyYUVImageChromaFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                            stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> u, stdVectorView2D<unsigned char> v,
+                                            Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Same as above, but only the combined color edge strength, the saturated sum of the results of U and V, is stored into color.
+   * @see sobelSSEAnyYUVImageChromaFull
+   */
+  static void sobelSSEAnyYUVImageChromaFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                            stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> color,
+                                            Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Same as sobelSSEAnyYUVImageChromaFull on the quarter image, i.e. using every second Y value and every second row. Every pixel of
+   * the quarter image is one pixel pair, so the chroma results have the same size and rectangle as magnitude. The U and V values are always
+   * those of the row itself, also with BoxAverage.
+   * @see sobelSSEAnyYUVImageChromaFull
+   */
+  static void sobelSSEAnyYUVImageChromaQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                               stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> u, stdVectorView2D<unsigned char> v,
+                                               Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Same as above, but only the combined color edge strength is stored into color.
+   * @see sobelSSEAnyYUVImageChromaFull
+   */
+  static void sobelSSEAnyYUVImageChromaQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                               stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> color,
+                                               Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Calculates thin canny edges of an image using every Y value. The sobel result is thinned by non-maximum suppression along the
+   * gradient orientation (see sobelSSEAnyYUVImageOrientationFull) and then thresholded with hysteresis: pixels with a magnitude of at least
+   * highThreshold are edges, as well as pixels of at least lowThreshold connected to them.
+   * Everything is streamed row by row behind the sobel kernel, so the magnitude is never stored and the image is read once. The rows depend on
+   * each other, so this always runs on the calling thread. Only the weak edges still unconnected at the end are written again, to clear them.
+   * Rectangles wider than 4096 pixels are split into independent strips: edges do not connect across strips and the outer columns of every
+   * strip are never edges, like the border of the rectangle.
+   * @param [out] edges Caller owned buffer, every edge is set to 255 and everything else to 0. With returnFullArray it has to be at least
+   * width by height, otherwise at least the size of the rectangle.
+   * @param [in] lowThreshold Minimum magnitude of pixels connected to an edge.
+   * @param [in] highThreshold Minimum magnitude of pixels starting an edge.
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEAnyYUVImageCannyFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                           stdVectorView2D<unsigned char> edges, unsigned char lowThreshold, unsigned char highThreshold,
+                                           bool returnFullArray = true);
+
+  /**
+   * @brief Same as sobelSSEAnyYUVImageCannyFull on the quarter image, i.e. using every second Y value and every second row.
+   * @see sobelSSEAnyYUVImageCannyFull
+   */
+  static void sobelSSEAnyYUVImageCannyQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                              stdVectorView2D<unsigned char> edges, unsigned char lowThreshold, unsigned char highThreshold,
+                                              bool returnFullArray = true);
+
+  /**
+   * @brief Returns only the pixels of the sobel image using every Y value whose result is at least threshold, ordered by row and column
+   * (rectangles wider than 2048 pixels are calculated in strips, whose points follow each other). The points are collected by the kernel, so the dense result does not have to be searched afterwards. The sobel result is
+   * the same as of sobelSSEAnyYUVImageFull, only the border of the rectangle is never a point. The rectangle is clipped to width and height.
+   * @param [out] points Cleared and then filled with the points. Its memory is reused, so once it is large enough nothing is allocated.
+   * @param [in] threshold Minimum sobel result of a point.
+   * @param [in] withGradients If the exact signed gradients of each point are calculated as well.
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEAnyYUVImageEdgePointsFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                std::vector<EdgePoint>& points, unsigned char threshold, bool withGradients = false,
+                                                Direction dir = Uni);
+
+  /**
+   * @brief Same as above, but the dense sobel result is written into target as well, like sobelSSEAnyYUVImageFull does.
+   * @see sobelSSEAnyYUVImageEdgePointsFull
+   */
+  static void sobelSSEAnyYUVImageEdgePointsFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                std::vector<EdgePoint>& points, unsigned char threshold, stdVectorView2D<unsigned char> target,
+                                                bool withGradients = false, Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Same as sobelSSEAnyYUVImageEdgePointsFull on the quarter image, i.e. using every second Y value and every second row.
+   * The coordinates of the points are those of the quarter image.
+   * @see sobelSSEAnyYUVImageEdgePointsFull
+   */
+  static void sobelSSEAnyYUVImageEdgePointsQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                   std::vector<EdgePoint>& points, unsigned char threshold, bool withGradients = false,
+                                                   Direction dir = Uni);
+
+  /**
+   * @brief Same as above, but the dense sobel result is written into target as well, like sobelSSEAnyYUVImageQuarter does.
+   * @see sobelSSEAnyYUVImageEdgePointsFull
+   */
+  static void sobelSSEAnyYUVImageEdgePointsQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                   std::vector<EdgePoint>& points, unsigned char threshold, stdVectorView2D<unsigned char> target,
+                                                   bool withGradients = false, Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Calculates the rectangle like sobelSSEAnyYUVImageFull with the given gradient operator. The border of the rectangle, where the
+   * surrounding of the operator is not part of it, and with returnFullArray everything outside of it are set to 0.
+   * @param [out] target Caller owned buffer for the result. With returnFullArray it has to be at least width by height, otherwise
+   * at least the size of the rectangle.
+   * @param [in] op The gradient operator, Sobel3x3 gives the same result as sobelSSEAnyYUVImageFull with BorderZero.
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEAnyYUVImageOperatorFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                              stdVectorView2D<unsigned char> target, Operator op, Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Same as sobelSSEAnyYUVImageOperatorFull on the quarter image, i.e. using every second Y value and every second row.
+   * @see sobelSSEAnyYUVImageOperatorFull
+   */
+  static void sobelSSEAnyYUVImageOperatorQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                 stdVectorView2D<unsigned char> target, Operator op, Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Calculates the sobel image like sobelSSEAnyYUVImageFull on the Y values smoothed with a gaussian, e.g. against camera noise in poor
+   * lighting. The smoothing is done on the extracted rows of the kernel, so no smoothed image is stored and the image is read only once.
+   * The border of the rectangle, where the surrounding of the gaussian and the sobel operator is not part of it, and with returnFullArray
+   * everything outside of it are set to 0.
+   * @param [out] target Caller owned buffer for the result. With returnFullArray it has to be at least width by height, otherwise
+   * at least the size of the rectangle.
+   * @param [in] smoothing The gaussian.
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEAnyYUVImageSmoothedFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                              stdVectorView2D<unsigned char> target, Smoothing smoothing, Direction dir = Uni,
+                                              bool returnFullArray = true);
+
+  /**
+   * @brief Same as sobelSSEAnyYUVImageSmoothedFull on the quarter image, i.e. using every second Y value and every second row.
+   * @see sobelSSEAnyYUVImageSmoothedFull
+   */
+  static void sobelSSEAnyYUVImageSmoothedQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                 stdVectorView2D<unsigned char> target, Smoothing smoothing, Direction dir = Uni,
+                                                 bool returnFullArray = true);
+
+  /**
+   * @brief Overloaded function taking the robots upper image and writing the smoothed sobel result of the whole image into a caller owned
+   * buffer of at least the full upper image size.
+   * @see sobelSSEAnyYUVImageSmoothedFull
+   */
+  static void sobelSSEImageUpperSmoothedFull(const unsigned char* imageUpper, stdVectorView2D<unsigned char> target, Smoothing smoothing,
+                                             Direction dir = Uni)
+  {
+    sobelSSEAnyYUVImageSmoothedFull(cameraProfiles[UpperCamera].input(imageUpper), 0, 0, cameraProfiles[UpperCamera].lastX, cameraProfiles[UpperCamera].lastY,
+                                    cameraProfiles[UpperCamera].width, cameraProfiles[UpperCamera].height, target, smoothing, dir, true);
+  }
+
+  /**
+   * @brief Overloaded function taking the robots lower image and writing the smoothed sobel result of the whole image into a caller owned
+   * buffer of at least the full lower image size.
+   * @see sobelSSEAnyYUVImageSmoothedFull
+   */
+  static void sobelSSEImageLowerSmoothedFull(const unsigned char* imageLower, stdVectorView2D<unsigned char> target, Smoothing smoothing,
+                                             Direction dir = Uni)
+  {
+    sobelSSEAnyYUVImageSmoothedFull(cameraProfiles[LowerCamera].input(imageLower), 0, 0, cameraProfiles[LowerCamera].lastX, cameraProfiles[LowerCamera].lastY,
+                                    cameraProfiles[LowerCamera].width, cameraProfiles[LowerCamera].height, target, smoothing, dir, true);
+  }
+
+  /**
+   * @brief Calculates the sobel image like sobelSSEAnyYUVImageFull and in the same pass statistics of the results per tile, while they are still
+   * in registers. So e.g. adaptive thresholds or exposure checks do not have to read the result again. The rectangle is split into tiles of
+   * tileSize by tileSize pixels starting at its top left corner, the last ones may be smaller. Only the calculated pixels are counted, not the
+   * border of the rectangle, which is set to 0 like everything outside of it with returnFullArray. No memory is allocated once statistics
+   * is large enough. Tile sizes that are multiples of 16 are the fastest.
+   * @param [out] target Caller owned buffer for the sobel result. With returnFullArray it has to be at least width by height, otherwise
+   * at least the size of the rectangle.
+   * @param [out] statistics Resized to the number of tiles and filled with their statistics, row by row.
+   * @param [in] tileSize Width and height of the tiles, at least 1.
+   * @param [in] threshold Minimum result counted by TileStatistics::count.
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEAnyYUVImageStatisticsFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                stdVectorView2D<unsigned char> target, std::vector<TileStatistics>& statistics, int tileSize,
+                                                unsigned char threshold, Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Same as sobelSSEAnyYUVImageStatisticsFull on the quarter image, i.e. using every second Y value and every second row.
+   * @see sobelSSEAnyYUVImageStatisticsFull
+   */
+  static void sobelSSEAnyYUVImageStatisticsQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                   stdVectorView2D<unsigned char> target, std::vector<TileStatistics>& statistics, int tileSize,
+                                                   unsigned char threshold, Direction dir = Uni, bool returnFullArray = true);
+
+  /**
+   * @brief Calculates the sobel images of three levels of an image pyramid in a single pass over the image. The first level is the quarter
+   * image using BoxAverage, each further level is the 2x2 box average of the level above, so they are 1/2, 1/4 and 1/8 of the width and height
+   * of the image. Only a few rows of every level are kept while the image is read, so it is read only once. The border of every level is set
+   * to 0 like by sobelSSEAnyYUVImageQuarter, i.e. level1 is the same as its result with BoxAverage for the whole image.
+   * @param [in] YUVImage The image on which the sobel is calculated, its quarterSampling is not used.
+   * @param [in] width Width of the full image.
+   * @param [in] height Height of the full image.
+   * @param [out] level1 Sobel result of width / 2 by height / 2 pixels.
+   * @param [out] level2 Sobel result of width / 4 by height / 4 pixels.
+   * @param [out] level3 Sobel result of width / 8 by height / 8 pixels.
+   * @param [in] dir If you want the normal sobel in both horizontal and vertical directions or only one of them.
+   */
+  static void sobelSSEAnyYUVImagePyramid(const InputImage& YUVImage, int width, int height, stdVectorView2D<unsigned char> level1,
+                                         stdVectorView2D<unsigned char> level2, stdVectorView2D<unsigned char> level3, Direction dir = Uni);
+
+  /**
+   * @brief Calculates the sobel results of several rectangles of the same image in one call, using every Y value. Overlapping rectangles are
+   * merged into one region if its bounding box is not larger than both of them together, so the Y values and results shared by them are only
+   * calculated once. Every region is calculated like sobelSSEAnyYUVImageFull with BorderReplicate, so the result of every rectangle is the same
+   * as that function would return with returnFullArray = false and BorderReplicate, independent of how the rectangles are merged.
+   * All regions are calculated in one sweep over the rows, so every row and column needed by several regions, e.g. the overlap of rectangles
+   * whose bounding box is too large to merge, is only extracted once. Only the results of such an overlap are calculated once per region.
+   * @param [in] rectangles The rectangles, e.g. the candidates of all perception modules for this frame.
+   * @param [out] result Receives one view per rectangle, which stays valid until result is used again.
+   * @see sobelSSEAnyYUVImageFull
+   */
+  static void sobelSSEAnyYUVImageFullBatch(const InputImage& YUVImage, const std::vector<Rectangle>& rectangles, int width, int height,
+                                           BatchResult& result, Direction dir = Uni);
+
+  /**
+   * @brief Same as sobelSSEAnyYUVImageFullBatch on the quarter image, i.e. using every second Y value and every second row.
+   * @see sobelSSEAnyYUVImageFullBatch
+   */
+  static void sobelSSEAnyYUVImageQuarterBatch(const InputImage& YUVImage, const std::vector<Rectangle>& rectangles, int width, int height,
+                                              BatchResult& result, Direction dir = Uni);
+
+  /**
+   * @brief Overloaded function taking the robots upper image instead of any image.
+   * @see sobelSSEAnyYUVImageFullBatch
+   */
+  static void sobelSSEImageUpperFullBatch(const unsigned char* imageUpper, const std::vector<Rectangle>& rectangles, BatchResult& result,
+                                          Direction dir = Uni)
+  {
+    sobelSSEAnyYUVImageFullBatch(cameraProfiles[UpperCamera].input(imageUpper), rectangles, cameraProfiles[UpperCamera].width, cameraProfiles[UpperCamera].height, result, dir);
+  }
+
+  /**
+   * @brief Overloaded function taking the robots lower image instead of any image.
+   * @see sobelSSEAnyYUVImageFullBatch
+   */
+  static void sobelSSEImageLowerFullBatch(const unsigned char* imageLower, const std::vector<Rectangle>& rectangles, BatchResult& result,
+                                          Direction dir = Uni)
+  {
+    sobelSSEAnyYUVImageFullBatch(cameraProfiles[LowerCamera].input(imageLower), rectangles, cameraProfiles[LowerCamera].width, cameraProfiles[LowerCamera].height, result, dir);
+  }
+
+  /**
+   * @brief Calculates the sobel result only along vertical and horizontal scanlines using every Y value, e.g. along the sparse scan grid of the
+   * field line and obstacle detection. Every value is the same as the one of sobelSSEAnyYUVImageFull for the whole image, so it is 0 at the
+   * border of the image and along scanlines outside of it. The column scanlines are calculated down the columns with full registers, so a grid
+   * of every 16th column costs only a fraction of the whole image.
+   * @param [in] YUVImage The image on which the sobel is calculated.
+   * @param [in] columns The x coordinates of the vertical scanlines.
+   * @param [in] rows The y coordinates of the horizontal scanlines.
+   * @param [in] width Width of the image.
+   * @param [in] height Height of the image.
+   * @param [out] result Receives the results along the scanlines, which stay valid until result is used again.
+   * @param [in] dir If you want the normal sobel in both horizontal and vertical directions or only one of them.
+   */
+  static void sobelSSEAnyYUVImageFullScanlines(const InputImage& YUVImage, const std::vector<int>& columns, const std::vector<int>& rows, int width,
+                                               int height, ScanlineResult& result, Direction dir = Uni);
+
+  /**
+   * @brief Same as sobelSSEAnyYUVImageFullScanlines on the quarter image, i.e. using every second Y value and every second row. The scanlines,
+   * width and height are those of the quarter image.
+   * @see sobelSSEAnyYUVImageFullScanlines
+   */
+  static void sobelSSEAnyYUVImageQuarterScanlines(const InputImage& YUVImage, const std::vector<int>& columns, const std::vector<int>& rows,
+                                                  int width, int height, ScanlineResult& result, Direction dir = Uni);
+
+  /**
+   * @brief Overloaded function taking the robots upper image instead of any image.
+   * @see sobelSSEAnyYUVImageFullScanlines
+   */
+  static void sobelSSEImageUpperFullScanlines(const unsigned char* imageUpper, const std::vector<int>& columns, const std::vector<int>& rows,
+                                              ScanlineResult& result, Direction dir = Uni)
+  {
+    sobelSSEAnyYUVImageFullScanlines(cameraProfiles[UpperCamera].input(imageUpper), columns, rows, cameraProfiles[UpperCamera].width, cameraProfiles[UpperCamera].height, result, dir);
+  }
+
+  /**
+   * @brief Overloaded function taking the robots lower image instead of any image.
+   * @see sobelSSEAnyYUVImageFullScanlines
+   */
+  static void sobelSSEImageLowerFullScanlines(const unsigned char* imageLower, const std::vector<int>& columns, const std::vector<int>& rows,
+                                              ScanlineResult& result, Direction dir = Uni)
+  {
+    sobelSSEAnyYUVImageFullScanlines(cameraProfiles[LowerCamera].input(imageLower), columns, rows, cameraProfiles[LowerCamera].width, cameraProfiles[LowerCamera].height, result, dir);
+  }
+
+  /**
+   * @brief Calculates the sobel image of a frame while its rows arrive, e.g. from the camera driver, instead of waiting for the whole frame.
+   * The result of a row is finished as soon as the row below it has been pushed, so downstream scanning can follow one row behind the
+   * readout. Only the Y values of 3 rows are kept. The result is the same as of sobelSSEAnyYUVImageFull for the whole image, i.e. its border
+   * is set to 0.
+   */
+  class Stream
+  {
+   public:
+    /**
+     * @brief Constructor.
+     * @param [in] width Width of the image.
+     * @param [in] height Height of the image.
+     * @param [out] target View on the caller owned result buffer of at least width by height, whose rows are written as they are finished.
+     * @param [in] format Pixel format of the pushed rows.
+     * @param [in] dir If you want the normal sobel in both horizontal and vertical directions or only one of them.
+     */
+    Stream(int width, int height, stdVectorView2D<unsigned char> target, PixelFormat format = YUYV, Direction dir = Uni);
+
+    /**
+     * @brief Starts the next frame, which is written into the same target.
+     */
+    void reset();
+
+    /**
+     * @brief Pushes the next rows of the frame.
+     * @param [in] rows The first byte of the first pushed row.
+     * @param [in] count Number of pushed rows. Rows below the last row of the image are ignored.
+     * @param [in] rowStride Bytes between two of the pushed rows, 0 if they are not padded.
+     * @return The number of finished rows, i.e. the rows 0 to getFinishedRows() - 1 of the target are final.
+     */
+    int push(const unsigned char* rows, int count, int rowStride = 0);
+
+    /**
+     * @brief Returns the number of finished rows of the current frame.
+     * @return The rows 0 to getFinishedRows() - 1 of the target are final.
+     */
+    int getFinishedRows() const;
+
+   private:
+    int width;
+    int height;
+    stdVectorView2D<unsigned char> target;
+    PixelFormat format;
+    Direction dir;
+    int pushedRows;                   ///< Number of rows of the current frame pushed so far.
+    std::vector<unsigned char> ring;  ///< The Y values of the last 3 pushed rows.
+  };
+
+  /**
+   * @brief Calculates the sobel image of consecutive frames of a camera, recalculating only the tiles whose input changed since the previous
+   * frame. While the robot stands still most of the image does not change, so most tiles keep their result. The Y values of every tile and the
+   * one pixel wide halo around it, which the 3x3 surrounding of its pixels reaches into, are compared with those the result was calculated from
+   * using the sum of their absolute differences. The dirty tiles are reported, so following detectors can skip the other ones as well.
+   * With threshold 0 the result is always the same as of sobelSSEAnyYUVImageFull (or Quarter) for the whole image, i.e. its border is 0.
+   */
+  class Incremental
+  {
+   public:
+    /**
+     * @brief Constructor.
+     * @param [in] width Width of the (full or quarter) image.
+     * @param [in] height Height of the (full or quarter) image.
+     * @param [in] quarter If the sobel is calculated on the quarter image like sobelSSEAnyYUVImageQuarter.
+     * @param [in] dir If you want the normal sobel in both horizontal and vertical directions or only one of them.
+     * @param [in] tileSize Width and height of the tiles, at least 1 (smaller values are used as 1). The tiles in the last row and column may
+     * be smaller.
+     * @param [in] threshold Maximum sum of the absolute differences of the Y values of a tile and its halo, up to which the tile is not
+     * recalculated. Above 0 this ignores camera noise, but the result of a tile may then differ slightly from a full calculation.
+     */
+    Incremental(int width, int height, bool quarter = false, Direction dir = Uni, int tileSize = 32, unsigned threshold = 0);
+
+    /**
+     * @brief Calculates the sobel image of the next frame.
+     * @param [in] image The frame, its pixel format and row stride may differ from the previous one.
+     * @return The number of recalculated (dirty) tiles.
+     */
+    int update(const InputImage& image);
+
+    /**
+     * @brief Recalculates every tile on the next update, e.g. after the camera settings changed.
+     */
+    void reset();
+
+    /**
+     * @brief Returns the sobel image of the last frame, width by height pixels.
+     */
+    const stdVector2D<unsigned char>& getResult() const { return result; }
+
+    /**
+     * @brief Returns per tile (row by row, getTilesX() per row) if it was recalculated by the last update. Tile (i, j) covers the pixels
+     * i * tileSize to (i + 1) * tileSize - 1 and j * tileSize to (j + 1) * tileSize - 1.
+     */
+    const std::vector<unsigned char>& getDirtyTiles() const { return dirtyTiles; }
+
+    int getTilesX() const { return tilesX; }
+    int getTilesY() const { return tilesY; }
+    int getTileSize() const { return tileSize; }
+
+   private:
+    int width;
+    int height;
+    bool quarter;
+    Direction dir;
+    int tileSize;
+    unsigned threshold;
+    int tilesX;
+    int tilesY;
+    bool valid;                               ///< If previous holds the Y values the result was calculated from.
+    stdVector2D<unsigned char> result;
+    std::vector<unsigned char> previous;      ///< The Y values the result of every tile was calculated from.
+    std::vector<unsigned char> current;       ///< The Y values of the current frame.
+    std::vector<unsigned> changes;            ///< Sum of the absolute differences of every tile and its halo.
+    std::vector<unsigned char> dirtyTiles;
+  };
+
  private:
    
-  //------------ Edit if you are using other image sizes --------------
-  // Constants regarding image sizes
-  static const int IMAGE_UPPER_FULL_WIDTH = 1280;
-  static const int IMAGE_UPPER_FULL_HEIGHT = 960;
-  static const int IMAGE_LOWER_FULL_WIDTH = 640;
-  static const int IMAGE_LOWER_FULL_HEIGHT = 480;
-  //-------------------------------------------------------------------
+  // The current image geometry of each camera, indexed by Camera. Defaults to 1280x960 for the upper and 640x480 for the lower camera.
+  static CameraProfile cameraProfiles[2];
 
   /**
    *
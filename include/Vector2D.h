@@ -4,13 +4,159 @@
 *
 * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
 */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
 #include <vector>
 
-template<typename T> class stdVector2D : public std::vector<T> {
+/**
+ * @brief Allocator returning memory aligned to alignment bytes, e.g. to a cache line. The kernels use aligned stores wherever a row of their
+ * result is aligned, so together with a padded stride (see stdVector2D::paddedStride) every row can be written that way.
+ */
+template<typename T, std::size_t alignment = 64> class AlignedAllocator {
+
+  static_assert((alignment & (alignment - 1)) == 0 && alignment >= sizeof(void*), "The alignment has to be a power of two of at least a pointer");
+
+public:
+  typedef T value_type;
+
+  template<typename U> struct rebind
+  {
+    typedef AlignedAllocator<U, alignment> other;
+  };
+
+  AlignedAllocator() {}
+
+  template<typename U> AlignedAllocator(const AlignedAllocator<U, alignment>&) {}
+
+  /**
+   * @brief Allocates memory for n elements.
+   * @param n Number of elements.
+   * @return Pointer to the first element, aligned to alignment bytes.
+   */
+  T* allocate(std::size_t n)
+  {
+    // The block is one alignment larger, the pointer to it is stored right in front of the aligned memory
+    void* block = std::malloc(n * sizeof(T) + alignment);
+    if (!block)
+    {
+      throw std::bad_alloc();
+    }
+    unsigned char* aligned = static_cast<unsigned char*>(block) + alignment - reinterpret_cast<std::uintptr_t>(block) % alignment;
+    reinterpret_cast<void**>(aligned)[-1] = block;
+    return reinterpret_cast<T*>(aligned);
+  }
+
+  /**
+   * @brief Frees memory returned by allocate.
+   * @param p Pointer returned by allocate.
+   */
+  void deallocate(T* p, std::size_t)
+  {
+    std::free(reinterpret_cast<void**>(p)[-1]);
+  }
+
+  template<typename U> bool operator==(const AlignedAllocator<U, alignment>&) const { return true; }
+
+  template<typename U> bool operator!=(const AlignedAllocator<U, alignment>&) const { return false; }
+};
+
+/**
+ * @brief Non-owning two dimensional view on a caller owned buffer. Rows are stride elements apart, so the view may
+ * describe a sub rectangle of a larger image or a buffer with padded rows. The view never allocates or frees memory.
+ */
+template<typename T> class stdVectorView2D {
 
 private:
+  T* dataPtr;
   int width;
   int height;
+  int stride;
+
+public:
+
+  /**
+   * @brief Constructor taking the buffer and its geometry
+   * @param data Pointer to the element at (0,0).
+   * @param width The width.
+   * @param height The height.
+   * @param stride Distance between two rows in elements. Defaults to width.
+   */
+  stdVectorView2D(T* data, int width, int height, int stride = 0) : dataPtr(data), width(width), height(height), stride(stride > 0 ? stride : width)
+  {
+  }
+
+  /**
+   * @brief Can be used to address the data as two dimensional
+   * @param x X coordinate
+   * @param y Y coordinate
+   * @return Value at (x,y)
+   */
+  T& operator() (int x, int y) const
+  {
+    return dataPtr[x + y*stride];
+  }
+
+  /**
+   * @brief Returns a pointer to the first element of a row
+   * @param y Y coordinate
+   * @return Pointer to (0,y)
+   */
+  T* row(int y) const
+  {
+    return dataPtr + y*stride;
+  }
+
+  /**
+   * @brief Returns the pointer to the element at (0,0)
+   * @return The data pointer.
+   */
+  T* data() const
+  {
+    return dataPtr;
+  }
+
+  /**
+   * @brief Returns the width of the view
+   * @return A copy of the width.
+   */
+  int getWidth() const
+  {
+    return width;
+  }
+
+  /**
+   * @brief Returns the height of the view
+   * @return A copy of the height.
+   */
+  int getHeight() const
+  {
+    return height;
+  }
+
+  /**
+   * @brief Returns the distance between two rows in elements
+   * @return A copy of the stride.
+   */
+  int getStride() const
+  {
+    return stride;
+  }
+};
+
+/**
+ * @brief Two dimensional vector. Rows are stride elements apart, which is the width unless the rows are padded.
+ * @param Allocator The allocator of the vector, e.g. AlignedAllocator for cache line aligned rows.
+ */
+template<typename T, typename Allocator = std::allocator<T> > class stdVector2D : public std::vector<T, Allocator> {
+
+private:
+  int width;
+  int height;
+  int stride;
 
 public:
 
@@ -18,10 +164,23 @@ public:
    * @brief Constructor taking width and height of the 2D vector
    * @param width The width.
    * @param height The height.
+   * @param stride Distance between two rows in elements. Defaults to width, see paddedStride for rows padded to a cache line.
    */
-  stdVector2D(int width, int height): width(width), height(height)
+  stdVector2D(int width, int height, int stride = 0): width(width), height(height), stride(stride > 0 ? stride : width)
   {
-    this->resize(width*height);
+    this->resize(this->stride*height);
+  }
+
+  /**
+   * @brief Returns the smallest stride of at least width elements that is a multiple of alignment bytes.
+   * @param width The width.
+   * @param alignment Alignment of every row in bytes, e.g. a cache line.
+   * @return The stride in elements.
+   */
+  static int paddedStride(int width, int alignment = 64)
+  {
+    const int bytes = (static_cast<int>(sizeof(T)) * width + alignment - 1) / alignment * alignment;
+    return (bytes + static_cast<int>(sizeof(T)) - 1) / static_cast<int>(sizeof(T));
   }
 
   /**
@@ -32,7 +191,7 @@ public:
    */
   const T& operator() (int x, int y) const
   {
-    return this->operator [](x + y*width);
+    return this->operator [](x + y*stride);
   }
 
   /**
@@ -43,7 +202,27 @@ public:
    */
   T& operator() (int x, int y)
   {
-    return this->operator [](x + y*width);
+    return this->operator [](x + y*stride);
+  }
+
+  /**
+   * @brief Returns a pointer to the first element of a row
+   * @param y Y coordinate
+   * @return Pointer to (0,y)
+   */
+  T* row(int y)
+  {
+    return this->data() + y*stride;
+  }
+
+  /**
+   * @brief Returns a pointer to the first element of a row
+   * @param y Y coordinate
+   * @return Pointer to (0,y)
+   */
+  const T* row(int y) const
+  {
+    return this->data() + y*stride;
   }
 
   /**
@@ -64,14 +243,54 @@ public:
     return height;
   }
 
+  /**
+   * @brief Returns the distance between two rows in elements
+   * @return A copy of the stride.
+   */
+  int getStride() const
+  {
+    return stride;
+  }
+
+  /**
+   * @brief Returns a non-owning view on the data of this 2D vector
+   * @return The view.
+   */
+  stdVectorView2D<T> view()
+  {
+    return stdVectorView2D<T>(this->data(), width, height, stride);
+  }
+
+  /**
+   * @brief Returns a non-owning read only view on the data of this 2D vector
+   * @return The view.
+   */
+  stdVectorView2D<const T> view() const
+  {
+    return stdVectorView2D<const T>(this->data(), width, height, stride);
+  }
+
   void setHeight(int height)
   {
     this->height = height;
   }
 
+  /**
+   * @brief Sets the width. Rows that were not padded stay unpadded, so the stride changes with the width.
+   * @param width The width.
+   */
   void setWidth(int width)
   {
+    if (stride == this->width)
+    {
+      stride = width;
+    }
     this->width = width;
   }
 
 };
+
+/**
+ * @brief 2D vector whose data is aligned to a cache line. Constructed with paddedStride every row is.
+ */
+template<typename T> using stdAlignedVector2D = stdVector2D<T, AlignedAllocator<T> >;
@@ -0,0 +1,174 @@
+/**
+ * @file src/SobelAVX2.cpp
+ *
+ * Instantiates the sobel kernels for 256-bit AVX2, which gives 32 results per iteration.
+ * This file has to be compiled with -mavx2. It is only called if the CPU supports AVX2, so nothing that is
+ * shared with the other translation units (e.g. inline functions of the std library) may be used in here,
+ * otherwise the linker could pick the AVX2 version of it for the SSSE3 code as well.
+ *
+ * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
+ */
+
+#ifndef __AVX2__
+#error "SobelAVX2.cpp has to be compiled with -mavx2"
+#endif
+
+#include <immintrin.h>
+#include <cstring>
+#include "SobelKernel.h"
+
+struct SobelAVX2
+{
+  typedef __m256i Vec;
+
+  // Number of 8-bit values in one register
+  static const int size = 32;
+
+  /**
+   * @brief Extracts 32 consecutive Y values of a YUV422 row into one register.
+   * @param p Pointer to the first Y value, 64 bytes are read.
+   */
+  static Vec extractY(const unsigned char* p)
+  {
+    // Every Y value is the low byte of a 16-bit value, so masking out U and V and packing with unsigned saturation
+    // leaves the Y values. The pack works on each 128-bit lane separately, which results in the
+    // 64-bit blocks Y0-Y7, Y16-Y23, Y8-Y15, Y24-Y31 that are brought in order by the permute.
+    const __m256i mask = _mm256_set1_epi16(0x00FF);
+    __m256i a = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), mask);
+    __m256i b = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)), mask);
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+  }
+
+  /**
+   * @brief Extracts every second of 64 consecutive Y values of a YUV422 row into one register.
+   * @param p Pointer to the first Y value, 128 bytes are read.
+   */
+  static Vec extractQuarterY(const unsigned char* p)
+  {
+    // Same as above, but every wanted Y value is the low byte of a 32-bit value, so it needs two packs.
+    // Afterwards the 32-bit blocks of 4 values each are ordered a0 b0 c0 d0 a1 b1 c1 d1 (a-d being the four loads).
+    const __m256i mask = _mm256_set1_epi32(0x000000FF);
+    __m256i a = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), mask);
+    __m256i b = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)), mask);
+    __m256i c = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 64)), mask);
+    __m256i d = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 96)), mask);
+    __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(a, b), _mm256_packus_epi32(c, d));
+    return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+  }
+
+  /**
+   * @brief Same as extractY for a UYVY row, where the Y values are the high bytes of the 16-bit values.
+   * @param p Pointer to the first U value, 64 bytes are read.
+   */
+  static Vec extractOddY(const unsigned char* p)
+  {
+    __m256i a = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), 8);
+    __m256i b = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)), 8);
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+  }
+
+  /**
+   * @brief Same as extractQuarterY for a UYVY row, where the wanted Y values are the second bytes of the 32-bit values.
+   * @param p Pointer to the first U value, 128 bytes are read.
+   */
+  static Vec extractQuarterOddY(const unsigned char* p)
+  {
+    const __m256i mask = _mm256_set1_epi32(0x000000FF);
+    __m256i a = _mm256_and_si256(_mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), 8), mask);
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)), 8), mask);
+    __m256i c = _mm256_and_si256(_mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 64)), 8), mask);
+    __m256i d = _mm256_and_si256(_mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 96)), 8), mask);
+    __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(a, b), _mm256_packus_epi32(c, d));
+    return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+  }
+
+  /**
+   * @brief Averages each 2x2 block of Y values with rounding. a0, a1 are 2 * 32 consecutive Y values of a row and b0, b1 those of the row below.
+   */
+  static Vec boxAverage(Vec a0, Vec a1, Vec b0, Vec b1)
+  {
+    // Same as for SSSE3, the pack works on each 128-bit lane separately, so the 64-bit blocks need to be brought in order like in extractY
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i two = _mm256_set1_epi16(2);
+    __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_maddubs_epi16(a0, ones), _mm256_maddubs_epi16(b0, ones)), two), 2);
+    __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_maddubs_epi16(a1, ones), _mm256_maddubs_epi16(b1, ones)), two), 2);
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+  }
+
+  // Divides each of the 8-bit values by 2 or 4, the bits shifted in from the neighbouring value are masked out
+  static Vec div2(Vec a) { return _mm256_and_si256(_mm256_srli_epi16(a, 1), _mm256_set1_epi8(0x7F)); }
+  static Vec div4(Vec a) { return _mm256_and_si256(_mm256_srli_epi16(a, 2), _mm256_set1_epi8(0x3F)); }
+
+  static Vec adds(Vec a, Vec b) { return _mm256_adds_epu8(a, b); }
+  static Vec subs(Vec a, Vec b) { return _mm256_subs_epu8(a, b); }
+  static Vec max(Vec a, Vec b) { return _mm256_max_epu8(a, b); }
+  static Vec min(Vec a, Vec b) { return _mm256_min_epu8(a, b); }
+
+  static Vec load(const unsigned char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+  static void store(unsigned char* p, Vec a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+  static Vec loadAligned(const unsigned char* p) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(p)); }
+  static void storeAligned(unsigned char* p, Vec a) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), a); }
+
+  // AVX2 has no byte masked store, so the register is spilled to the stack and only count bytes are copied
+  static void maskStore(unsigned char* p, Vec a, int count)
+  {
+    alignas(32) unsigned char buffer[32];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(buffer), a);
+    std::memcpy(p, buffer, count);
+  }
+};
+
+void sobelFullKernelAVX2(const SobelKernelArgs& args)
+{
+  sobelFullKernel<SobelAVX2>(args);
+}
+
+void sobelQuarterKernelAVX2(const SobelKernelArgs& args)
+{
+  sobelQuarterKernel<SobelAVX2>(args);
+}
+
+void sobelStreamKernelAVX2(const SobelStreamArgs& args)
+{
+  sobelStreamKernel<SobelAVX2>(args);
+}
+
+void sobelOperatorFullKernelAVX2(const SobelKernelArgs& args, SobelDortmund::Operator op)
+{
+  sobelOperatorFullKernel<SobelAVX2>(args, op);
+}
+
+void sobelOperatorQuarterKernelAVX2(const SobelKernelArgs& args, SobelDortmund::Operator op)
+{
+  sobelOperatorQuarterKernel<SobelAVX2>(args, op);
+}
+
+void sobelSmoothedFullKernelAVX2(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing)
+{
+  sobelSmoothedFullKernel<SobelAVX2>(args, smoothing);
+}
+
+void sobelSmoothedQuarterKernelAVX2(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing)
+{
+  sobelSmoothedQuarterKernel<SobelAVX2>(args, smoothing);
+}
+
+void sobelScanlineFullKernelAVX2(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines)
+{
+  sobelScanlineFullKernel<SobelAVX2>(args, scanlines);
+}
+
+void sobelScanlineQuarterKernelAVX2(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines)
+{
+  sobelScanlineQuarterKernel<SobelAVX2>(args, scanlines);
+}
+
+void sobelBatchFullKernelAVX2(const SobelKernelArgs& args, const SobelBatchArgs& batch)
+{
+  sobelBatchFullKernel<SobelAVX2>(args, batch);
+}
+
+void sobelBatchQuarterKernelAVX2(const SobelKernelArgs& args, const SobelBatchArgs& batch)
+{
+  sobelBatchQuarterKernel<SobelAVX2>(args, batch);
+}
@@ -0,0 +1,166 @@
+/**
+ * @file src/SobelAVX512.cpp
+ *
+ * Instantiates the sobel kernels for 512-bit AVX-512BW, which gives 64 results per iteration.
+ * This file has to be compiled with -mavx512bw. It is only called if the CPU supports AVX-512BW, so nothing that is
+ * shared with the other translation units (e.g. inline functions of the std library) may be used in here,
+ * otherwise the linker could pick the AVX-512 version of it for the SSSE3 code as well.
+ *
+ * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
+ */
+
+#ifndef __AVX512BW__
+#error "SobelAVX512.cpp has to be compiled with -mavx512bw"
+#endif
+
+#include <immintrin.h>
+#include "SobelKernel.h"
+
+struct SobelAVX512BW
+{
+  typedef __m512i Vec;
+
+  // Number of 8-bit values in one register
+  static const int size = 64;
+
+  /**
+   * @brief Extracts 64 consecutive Y values of a YUV422 row into one register.
+   * @param p Pointer to the first Y value, 128 bytes are read.
+   */
+  static Vec extractY(const unsigned char* p)
+  {
+    // Every Y value is the low byte of a 16-bit value, so masking out U and V and packing with unsigned saturation
+    // leaves the Y values. The pack works on each 128-bit lane separately, so the 64-bit blocks are ordered
+    // a0 b0 a1 b1 a2 b2 a3 b3 afterwards (a and b being the two loads) and need to be permuted.
+    const __m512i mask = _mm512_set1_epi16(0x00FF);
+    __m512i a = _mm512_and_si512(_mm512_loadu_si512(p), mask);
+    __m512i b = _mm512_and_si512(_mm512_loadu_si512(p + 64), mask);
+    return _mm512_permutexvar_epi64(_mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7), _mm512_packus_epi16(a, b));
+  }
+
+  /**
+   * @brief Extracts every second of 128 consecutive Y values of a YUV422 row into one register.
+   * @param p Pointer to the first Y value, 256 bytes are read.
+   */
+  static Vec extractQuarterY(const unsigned char* p)
+  {
+    // Same as above, but every wanted Y value is the low byte of a 32-bit value, so it needs two packs.
+    // Afterwards the 32-bit blocks of 4 values each are ordered a0 b0 c0 d0 a1 b1 c1 d1 ... (a-d being the four loads).
+    const __m512i mask = _mm512_set1_epi32(0x000000FF);
+    __m512i a = _mm512_and_si512(_mm512_loadu_si512(p), mask);
+    __m512i b = _mm512_and_si512(_mm512_loadu_si512(p + 64), mask);
+    __m512i c = _mm512_and_si512(_mm512_loadu_si512(p + 128), mask);
+    __m512i d = _mm512_and_si512(_mm512_loadu_si512(p + 192), mask);
+    __m512i packed = _mm512_packus_epi16(_mm512_packus_epi32(a, b), _mm512_packus_epi32(c, d));
+    return _mm512_permutexvar_epi32(_mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15), packed);
+  }
+
+  /**
+   * @brief Same as extractY for a UYVY row, where the Y values are the high bytes of the 16-bit values.
+   * @param p Pointer to the first U value, 128 bytes are read.
+   */
+  static Vec extractOddY(const unsigned char* p)
+  {
+    __m512i a = _mm512_srli_epi16(_mm512_loadu_si512(p), 8);
+    __m512i b = _mm512_srli_epi16(_mm512_loadu_si512(p + 64), 8);
+    return _mm512_permutexvar_epi64(_mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7), _mm512_packus_epi16(a, b));
+  }
+
+  /**
+   * @brief Same as extractQuarterY for a UYVY row, where the wanted Y values are the second bytes of the 32-bit values.
+   * @param p Pointer to the first U value, 256 bytes are read.
+   */
+  static Vec extractQuarterOddY(const unsigned char* p)
+  {
+    const __m512i mask = _mm512_set1_epi32(0x000000FF);
+    __m512i a = _mm512_and_si512(_mm512_srli_epi32(_mm512_loadu_si512(p), 8), mask);
+    __m512i b = _mm512_and_si512(_mm512_srli_epi32(_mm512_loadu_si512(p + 64), 8), mask);
+    __m512i c = _mm512_and_si512(_mm512_srli_epi32(_mm512_loadu_si512(p + 128), 8), mask);
+    __m512i d = _mm512_and_si512(_mm512_srli_epi32(_mm512_loadu_si512(p + 192), 8), mask);
+    __m512i packed = _mm512_packus_epi16(_mm512_packus_epi32(a, b), _mm512_packus_epi32(c, d));
+    return _mm512_permutexvar_epi32(_mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15), packed);
+  }
+
+  /**
+   * @brief Averages each 2x2 block of Y values with rounding. a0, a1 are 2 * 64 consecutive Y values of a row and b0, b1 those of the row below.
+   */
+  static Vec boxAverage(Vec a0, Vec a1, Vec b0, Vec b1)
+  {
+    // Same as for SSSE3, the pack works on each 128-bit lane separately, so the 64-bit blocks need to be brought in order like in extractY
+    const __m512i ones = _mm512_set1_epi8(1);
+    const __m512i two = _mm512_set1_epi16(2);
+    __m512i lo = _mm512_srli_epi16(_mm512_add_epi16(_mm512_add_epi16(_mm512_maddubs_epi16(a0, ones), _mm512_maddubs_epi16(b0, ones)), two), 2);
+    __m512i hi = _mm512_srli_epi16(_mm512_add_epi16(_mm512_add_epi16(_mm512_maddubs_epi16(a1, ones), _mm512_maddubs_epi16(b1, ones)), two), 2);
+    return _mm512_permutexvar_epi64(_mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7), _mm512_packus_epi16(lo, hi));
+  }
+
+  // Divides each of the 8-bit values by 2 or 4, the bits shifted in from the neighbouring value are masked out
+  static Vec div2(Vec a) { return _mm512_and_si512(_mm512_srli_epi16(a, 1), _mm512_set1_epi8(0x7F)); }
+  static Vec div4(Vec a) { return _mm512_and_si512(_mm512_srli_epi16(a, 2), _mm512_set1_epi8(0x3F)); }
+
+  static Vec adds(Vec a, Vec b) { return _mm512_adds_epu8(a, b); }
+  static Vec subs(Vec a, Vec b) { return _mm512_subs_epu8(a, b); }
+  static Vec max(Vec a, Vec b) { return _mm512_max_epu8(a, b); }
+  static Vec min(Vec a, Vec b) { return _mm512_min_epu8(a, b); }
+
+  static Vec load(const unsigned char* p) { return _mm512_loadu_si512(p); }
+  static void store(unsigned char* p, Vec a) { _mm512_storeu_si512(p, a); }
+  static Vec loadAligned(const unsigned char* p) { return _mm512_load_si512(p); }
+  static void storeAligned(unsigned char* p, Vec a) { _mm512_store_si512(p, a); }
+  static void maskStore(unsigned char* p, Vec a, int count) { _mm512_mask_storeu_epi8(p, (1ULL << count) - 1, a); }
+};
+
+void sobelFullKernelAVX512BW(const SobelKernelArgs& args)
+{
+  sobelFullKernel<SobelAVX512BW>(args);
+}
+
+void sobelQuarterKernelAVX512BW(const SobelKernelArgs& args)
+{
+  sobelQuarterKernel<SobelAVX512BW>(args);
+}
+
+void sobelStreamKernelAVX512BW(const SobelStreamArgs& args)
+{
+  sobelStreamKernel<SobelAVX512BW>(args);
+}
+
+void sobelOperatorFullKernelAVX512BW(const SobelKernelArgs& args, SobelDortmund::Operator op)
+{
+  sobelOperatorFullKernel<SobelAVX512BW>(args, op);
+}
+
+void sobelOperatorQuarterKernelAVX512BW(const SobelKernelArgs& args, SobelDortmund::Operator op)
+{
+  sobelOperatorQuarterKernel<SobelAVX512BW>(args, op);
+}
+
+void sobelSmoothedFullKernelAVX512BW(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing)
+{
+  sobelSmoothedFullKernel<SobelAVX512BW>(args, smoothing);
+}
+
+void sobelSmoothedQuarterKernelAVX512BW(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing)
+{
+  sobelSmoothedQuarterKernel<SobelAVX512BW>(args, smoothing);
+}
+
+void sobelScanlineFullKernelAVX512BW(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines)
+{
+  sobelScanlineFullKernel<SobelAVX512BW>(args, scanlines);
+}
+
+void sobelScanlineQuarterKernelAVX512BW(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines)
+{
+  sobelScanlineQuarterKernel<SobelAVX512BW>(args, scanlines);
+}
+
+void sobelBatchFullKernelAVX512BW(const SobelKernelArgs& args, const SobelBatchArgs& batch)
+{
+  sobelBatchFullKernel<SobelAVX512BW>(args, batch);
+}
+
+void sobelBatchQuarterKernelAVX512BW(const SobelKernelArgs& args, const SobelBatchArgs& batch)
+{
+  sobelBatchQuarterKernel<SobelAVX512BW>(args, batch);
+}
@@ -1,528 +1,1476 @@
-#include <tmmintrin.h>
 #include "SobelDortmund.h"
+#include "SobelInstrumentation.h"
+#include "SobelKernel.h"
+#include "SobelScalar.h"
+#include "SobelThreadPool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+#ifdef SOBEL_PORTABLE
+#include "SobelVector.h"
+
+// Without intrinsics the portable traits take the place of SSSE3 and there are no wider kernels
+typedef SobelVector SobelBaseline;
+#else
+#include "SobelSSSE3.h"
+
+typedef SobelSSSE3 SobelBaseline;
+
+// Kernels of the other instruction sets, see SobelAVX2.cpp and SobelAVX512.cpp
+void sobelFullKernelAVX2(const SobelKernelArgs& args);
+void sobelQuarterKernelAVX2(const SobelKernelArgs& args);
+void sobelStreamKernelAVX2(const SobelStreamArgs& args);
+void sobelOperatorFullKernelAVX2(const SobelKernelArgs& args, SobelDortmund::Operator op);
+void sobelOperatorQuarterKernelAVX2(const SobelKernelArgs& args, SobelDortmund::Operator op);
+void sobelSmoothedFullKernelAVX2(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing);
+void sobelSmoothedQuarterKernelAVX2(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing);
+void sobelScanlineFullKernelAVX2(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines);
+void sobelScanlineQuarterKernelAVX2(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines);
+void sobelBatchFullKernelAVX2(const SobelKernelArgs& args, const SobelBatchArgs& batch);
+void sobelBatchQuarterKernelAVX2(const SobelKernelArgs& args, const SobelBatchArgs& batch);
+void sobelFullKernelAVX512BW(const SobelKernelArgs& args);
+void sobelQuarterKernelAVX512BW(const SobelKernelArgs& args);
+void sobelStreamKernelAVX512BW(const SobelStreamArgs& args);
+void sobelOperatorFullKernelAVX512BW(const SobelKernelArgs& args, SobelDortmund::Operator op);
+void sobelOperatorQuarterKernelAVX512BW(const SobelKernelArgs& args, SobelDortmund::Operator op);
+void sobelSmoothedFullKernelAVX512BW(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing);
+void sobelSmoothedQuarterKernelAVX512BW(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing);
+void sobelScanlineFullKernelAVX512BW(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines);
+void sobelScanlineQuarterKernelAVX512BW(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines);
+void sobelBatchFullKernelAVX512BW(const SobelKernelArgs& args, const SobelBatchArgs& batch);
+void sobelBatchQuarterKernelAVX512BW(const SobelKernelArgs& args, const SobelBatchArgs& batch);
+#endif
+
+struct SobelKernels
+{
+  void (*full)(const SobelKernelArgs&);
+  void (*quarter)(const SobelKernelArgs&);
+  void (*stream)(const SobelStreamArgs&);
+  void (*operatorFull)(const SobelKernelArgs&, SobelDortmund::Operator);
+  void (*operatorQuarter)(const SobelKernelArgs&, SobelDortmund::Operator);
+  void (*smoothedFull)(const SobelKernelArgs&, SobelDortmund::Smoothing);
+  void (*smoothedQuarter)(const SobelKernelArgs&, SobelDortmund::Smoothing);
+  void (*scanlineFull)(const SobelKernelArgs&, const SobelScanlineArgs&);
+  void (*scanlineQuarter)(const SobelKernelArgs&, const SobelScanlineArgs&);
+  void (*batchFull)(const SobelKernelArgs&, const SobelBatchArgs&);
+  void (*batchQuarter)(const SobelKernelArgs&, const SobelBatchArgs&);
+};
+
+// Indexed by SobelDortmund::InstructionSet
+static const SobelKernels kernelsPerInstructionSet[] =
+{
+  { sobelFullKernel<SobelBaseline>, sobelQuarterKernel<SobelBaseline>, sobelStreamKernel<SobelBaseline>,
+    sobelOperatorFullKernel<SobelBaseline>, sobelOperatorQuarterKernel<SobelBaseline>,
+    sobelSmoothedFullKernel<SobelBaseline>, sobelSmoothedQuarterKernel<SobelBaseline>,
+    sobelScanlineFullKernel<SobelBaseline>, sobelScanlineQuarterKernel<SobelBaseline>,
+    sobelBatchFullKernel<SobelBaseline>, sobelBatchQuarterKernel<SobelBaseline> },
+#ifndef SOBEL_PORTABLE
+  { sobelFullKernelAVX2, sobelQuarterKernelAVX2, sobelStreamKernelAVX2, sobelOperatorFullKernelAVX2, sobelOperatorQuarterKernelAVX2,
+    sobelSmoothedFullKernelAVX2, sobelSmoothedQuarterKernelAVX2, sobelScanlineFullKernelAVX2, sobelScanlineQuarterKernelAVX2,
+    sobelBatchFullKernelAVX2, sobelBatchQuarterKernelAVX2 },
+  { sobelFullKernelAVX512BW, sobelQuarterKernelAVX512BW, sobelStreamKernelAVX512BW, sobelOperatorFullKernelAVX512BW,
+    sobelOperatorQuarterKernelAVX512BW, sobelSmoothedFullKernelAVX512BW, sobelSmoothedQuarterKernelAVX512BW,
+    sobelScanlineFullKernelAVX512BW, sobelScanlineQuarterKernelAVX512BW, sobelBatchFullKernelAVX512BW, sobelBatchQuarterKernelAVX512BW }
+#endif
+};
+
+/**
+ * @brief Returns the widest instruction set the CPU and the operating system support.
+ */
+static SobelDortmund::InstructionSet detectInstructionSet()
+{
+#ifndef SOBEL_PORTABLE
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw"))
+  {
+    return SobelDortmund::AVX512BW;
+  }
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return SobelDortmund::AVX2;
+  }
+#endif
+  return SobelDortmund::SSSE3;
+}
 
+/**
+ * @brief The instruction set used by all sobel functions, detected once on first use.
+ */
+static SobelDortmund::InstructionSet& activeInstructionSet()
+{
+  static SobelDortmund::InstructionSet instructionSet = detectInstructionSet();
+  return instructionSet;
+}
 
-const stdVector2D<unsigned char> SobelDortmund::sobelSSEAnyYUVImageFull(const unsigned char* YUVImage, int startX, int startY, int endX, int endY, int width, int height,
-                                                                  Direction dir, bool returnFullArray)
+static const SobelKernels& kernels()
 {
+  return kernelsPerInstructionSet[activeInstructionSet()];
+}
 
+/**
+ * @brief Returns the bytes between two columns of the (full or quarter) image in the input image.
+ */
+static int bytesPerColumn(SobelDortmund::PixelFormat format, bool quarter)
+{
+  const int bytesPerPixel = format == SobelDortmund::Y8 ? 1 : 2;
+  return quarter ? 2 * bytesPerPixel : bytesPerPixel;
+}
 
-  switchStartEnd(startX, startY, endX, endY);
-  int rectWidth = endX - startX + 1;
-  int rectHeight = endY - startY + 1;
+/**
+ * @brief Fills the kernel arguments for calculating the inner pixels of a rectangle, i.e. everything but its border.
+ * @param quarter Whether the coordinates are in the quarter image, which uses every second row and every second Y value.
+ * @param width Width of the (full or quarter) image.
+ */
+static SobelKernelArgs makeKernelArgs(const SobelDortmund::InputImage& image, bool quarter, int width, int startX, int startY, int endX, int endY,
+                                      SobelDortmund::Direction dir)
+{
+  // Without padding a row of the input image is exactly one row of the (full or quarter) image
+  const int fullRowStride = image.rowStride > 0 ? image.rowStride : bytesPerColumn(image.format, quarter) * width;
+
+  SobelKernelArgs args;
+  args.image = image.data;
+  args.format = image.format;
+  args.quarterSampling = image.quarterSampling;
+  args.rowStride = quarter ? 2 * fullRowStride : fullRowStride;
+  args.xBegin = startX + 1;
+  args.xEnd = endX;
+  args.yBegin = startY + 1;
+  args.yEnd = endY;
+  args.dir = dir;
+  args.target = nullptr;
+  args.targetStride = 0;
+  args.originX = startX;
+  args.originY = startY;
+  return args;
+}
+
+// Calculates the rows args.yBegin to args.yEnd - 1 of a band, context holds additional arguments of the kernel.
+// The bands are numbered from top to bottom.
+typedef void (*SobelBandFunction)(const SobelKernelArgs& args, const void* context, int band);
+
+static void runFullBand(const SobelKernelArgs& args, const void*, int)
+{
+  kernels().full(args);
+}
+
+static void runQuarterBand(const SobelKernelArgs& args, const void*, int)
+{
+  kernels().quarter(args);
+}
+
+// The context of the operator bands is the SobelDortmund::Operator
+static void runOperatorFullBand(const SobelKernelArgs& args, const void* context, int)
+{
+  kernels().operatorFull(args, *static_cast<const SobelDortmund::Operator*>(context));
+}
+
+static void runOperatorQuarterBand(const SobelKernelArgs& args, const void* context, int)
+{
+  kernels().operatorQuarter(args, *static_cast<const SobelDortmund::Operator*>(context));
+}
 
-  stdVector2D<unsigned char> targetData(rectHeight, rectWidth);
-  if (returnFullArray)
+// The context of the smoothed bands is the SobelDortmund::Smoothing
+static void runSmoothedFullBand(const SobelKernelArgs& args, const void* context, int)
+{
+  kernels().smoothedFull(args, *static_cast<const SobelDortmund::Smoothing*>(context));
+}
+
+static void runSmoothedQuarterBand(const SobelKernelArgs& args, const void* context, int)
+{
+  kernels().smoothedQuarter(args, *static_cast<const SobelDortmund::Smoothing*>(context));
+}
+
+// The context of the scanline bands is the SobelScanlineArgs
+static void runScanlineFullBand(const SobelKernelArgs& args, const void* context, int)
+{
+  kernels().scanlineFull(args, *static_cast<const SobelScanlineArgs*>(context));
+}
+
+static void runScanlineQuarterBand(const SobelKernelArgs& args, const void* context, int)
+{
+  kernels().scanlineQuarter(args, *static_cast<const SobelScanlineArgs*>(context));
+}
+
+// The context of the batch bands is the SobelBatchArgs
+static void runBatchFullBand(const SobelKernelArgs& args, const void* context, int)
+{
+  kernels().batchFull(args, *static_cast<const SobelBatchArgs*>(context));
+}
+
+static void runBatchQuarterBand(const SobelKernelArgs& args, const void* context, int)
+{
+  kernels().batchQuarter(args, *static_cast<const SobelBatchArgs*>(context));
+}
+
+static void runGradientFullBand(const SobelKernelArgs& args, const void* context, int)
+{
+  sobelGradientFullKernel<SobelBaseline>(args, *static_cast<const SobelGradientArgs*>(context));
+}
+
+static void runGradientQuarterBand(const SobelKernelArgs& args, const void* context, int)
+{
+  sobelGradientQuarterKernel<SobelBaseline>(args, *static_cast<const SobelGradientArgs*>(context));
+}
+
+static void runOrientationFullBand(const SobelKernelArgs& args, const void* context, int)
+{
+  sobelOrientationFullKernel<SobelBaseline>(args, *static_cast<const SobelOrientationArgs*>(context));
+}
+
+static void runOrientationQuarterBand(const SobelKernelArgs& args, const void* context, int)
+{
+  sobelOrientationQuarterKernel<SobelBaseline>(args, *static_cast<const SobelOrientationArgs*>(context));
+}
+
+static void runChromaFullBand(const SobelKernelArgs& args, const void* context, int)
+{
+  sobelChromaFullKernel<SobelBaseline>(args, *static_cast<const SobelChromaArgs*>(context));
+}
+
+static void runChromaQuarterBand(const SobelKernelArgs& args, const void* context, int)
+{
+  sobelChromaQuarterKernel<SobelBaseline>(args, *static_cast<const SobelChromaArgs*>(context));
+}
+
+/**
+ * @brief Context of the edge point bands. Every band collects its points separately, they are appended in the order of the bands afterwards.
+ */
+struct SobelEdgePointBands
+{
+  SobelEdgePointArgs edgePoints;
+  std::vector<SobelDortmund::EdgePoint>* bandPoints;  ///< Points of the bands 1 to n - 1, band 0 appends to edgePoints.points directly.
+};
+
+static void runEdgePointFullBand(const SobelKernelArgs& args, const void* context, int band)
+{
+  const SobelEdgePointBands& bands = *static_cast<const SobelEdgePointBands*>(context);
+  SobelEdgePointArgs edgePoints = bands.edgePoints;
+  if (band > 0)
   {
-      targetData.resize(width*height);
-      targetData.setWidth(width);
-      targetData.setHeight(height);
+    edgePoints.points = &bands.bandPoints[band - 1];
   }
+  sobelEdgePointFullKernel<SobelBaseline>(args, edgePoints);
+}
 
+static void runEdgePointQuarterBand(const SobelKernelArgs& args, const void* context, int band)
+{
+  const SobelEdgePointBands& bands = *static_cast<const SobelEdgePointBands*>(context);
+  SobelEdgePointArgs edgePoints = bands.edgePoints;
+  if (band > 0)
+  {
+    edgePoints.points = &bands.bandPoints[band - 1];
+  }
+  sobelEdgePointQuarterKernel<SobelBaseline>(args, edgePoints);
+}
 
-  unsigned char* target = targetData.data();
+/**
+ * @brief Context of the statistics bands. Every band accumulates into its own tiles, as a tile can be part of two bands.
+ */
+struct SobelStatisticsBands
+{
+  SobelStatisticsArgs statistics;
+  std::vector<SobelDortmund::TileStatistics>* bandTiles;  ///< Tiles of the bands 1 to n - 1, band 0 accumulates into statistics.tiles directly.
+};
+
+static void runStatisticsFullBand(const SobelKernelArgs& args, const void* context, int band)
+{
+  const SobelStatisticsBands& bands = *static_cast<const SobelStatisticsBands*>(context);
+  SobelStatisticsArgs statistics = bands.statistics;
+  if (band > 0)
+  {
+    statistics.tiles = bands.bandTiles[band - 1].data();
+  }
+  sobelStatisticsFullKernel<SobelBaseline>(args, statistics);
+}
+
+static void runStatisticsQuarterBand(const SobelKernelArgs& args, const void* context, int band)
+{
+  const SobelStatisticsBands& bands = *static_cast<const SobelStatisticsBands*>(context);
+  SobelStatisticsArgs statistics = bands.statistics;
+  if (band > 0)
+  {
+    statistics.tiles = bands.bandTiles[band - 1].data();
+  }
+  sobelStatisticsQuarterKernel<SobelBaseline>(args, statistics);
+}
 
-  // Calculate the pointers to the first element of the first 3 rows using pointer arithmetic
-  const unsigned char* row_0_ptr = YUVImage + startY * width * 2;
-  const unsigned char* row_1_ptr = row_0_ptr + 2 * width;
-  const unsigned char* row_2_ptr = row_0_ptr + 4 * width;
+// Used to split the rows into bands if more than one thread is set, see SobelDortmund::setThreadCount
+static std::unique_ptr<SobelThreadPool> threadPool;
 
+// Bands with less rows are not worth waking up another thread
+static const int minRowsPerBand = 16;
 
-  // Main Loop, we will start at (1,1) because Sobel needs a 3x3 surrounding, which is
-  // not available for edge pixels
-  // Every row will be looped through, but only every 14th column, because with 8 bit SSE
-  // it is possible to store 16 8-bit values in one SSE register, which will give 14 results (minus edge pixels included!)
-  for (int y = startY + 1; y < endY; y++)
+struct SobelBands
+{
+  SobelBandFunction function;
+  const void* context;
+  SobelKernelArgs args;
+  int count;
+};
+
+static void runBand(void* context, int band)
+{
+  const SobelBands& bands = *static_cast<const SobelBands*>(context);
+  const int rows = bands.args.yEnd - bands.args.yBegin;
+
+  // Each band reads one row above and below its rows, which overlaps with the neighbouring bands. The results do not overlap.
+  SobelKernelArgs args = bands.args;
+  args.yBegin = bands.args.yBegin + rows * band / bands.count;
+  args.yEnd = bands.args.yBegin + rows * (band + 1) / bands.count;
+  bands.function(args, bands.context, band);
+}
+
+/**
+ * @brief Runs a kernel, splitting the rows into horizontal bands which are calculated by the thread pool.
+ */
+static void runBands(SobelBandFunction function, const void* context, const SobelKernelArgs& args)
+{
+  int count = 1;
+  if (threadPool)
   {
-    for (int x = startX + 1; x < endX; x += 14)
-    {
-      // Now we need to load 16 Y values per row into 1 register
-      // This is done with SSE unpack, which works as in the following example:
-      // Pointer a: a0, a1, a3, ... , a15 | Pointer b: b0, b1, b3, ... , b15 (each value ai/bi has the size 1 Byte)
-      // _mm_unpacklo_epi8(a,b) will result in a register with the 16 8-Bit values: a0, b0, a1, b1, ... , a7, b7
-      // _mm_unpackhi_epi8(a,b) will result in a register with the 16 8-Bit values: a8, b8, a9, b9, ... , a15, b15
-      // We want to use these unpack operations to deinterlace our YUV422 array, so that we will have two registers
-      // one containing all the Y values in correct order and the other one containing all U and V values
-
-      // --------------------------------------------------------------------------------------------------------
-
-      // The following commands will deinterlace the Y values for the first row:
-      // Let the YUV422 array be: Y0, U0, Y1, V0, Y2, U1, Y3, V1, Y4, U2, Y5, V2, ...
-      // Unpack the first 16 Values with the second 16 values into a (lo)
-      // This will result in a = Y0, Y8, U0, U4, Y1, Y9, V0, V4, ...
-      // likewise b will be (hi): Y5, Y12, U2, U6, Y5, Y13, V2, V6, ...
-
-      // The pointer will need an offset of 2 * (x-1)
-      // -1: because we started this loop with x = 1
-      // 2 * : because only every second value is a Y value
-
-      __m128i loadA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_0_ptr + 2 * (x - 1)));
-      __m128i loadB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_0_ptr + 16 + 2 * (x - 1)));
-
-      __m128i a = _mm_unpacklo_epi8(loadA, loadB);
-      __m128i b = _mm_unpackhi_epi8(loadA, loadB);
-
-      // We will unpack again, resulting in 4 continous Y values per register
-      // i.e. c = Y0, Y4, Y8, Y12, U0, U2, U4, U6, ...
-      //      d = Y2, Y6, Y10, Y14, U1, U3, U5, U7, ...
-      __m128i c = _mm_unpacklo_epi8(a, b);
-      __m128i d = _mm_unpackhi_epi8(a, b);
-
-      // Next unpack will result in 8 continous Y values per register
-      // i.e. a = Y0, Y2, Y4, ... , Y14, U0, U1, ...
-      //      b = Y1, Y3, Y5, ... , Y15, V0, V1, ...
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-
-      // For the last unpack we only need the lower 8 values from each register, because these are the Y values
-      // row_0 = Y0, Y1, Y2, Y3, ... , Y15
-      // The unpackhi would give: U0, V0, U1, V1, ... but since we do not want to use the color values, this won't be calculated
-      __m128i row_0 = _mm_unpacklo_epi8(a, b);
-
-      // Same as above for second row
-      loadA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_1_ptr + 2 * (x - 1)));
-      loadB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_1_ptr + 16 + 2 * (x - 1)));
-      a = _mm_unpacklo_epi8(loadA, loadB);
-      b = _mm_unpackhi_epi8(loadA, loadB);
-      c = _mm_unpacklo_epi8(a, b);
-      d = _mm_unpackhi_epi8(a, b);
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-      __m128i row_1 = _mm_unpacklo_epi8(a, b);
-
-      // Same as above for third row
-      loadA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_2_ptr + 2 * (x - 1)));
-      loadB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_2_ptr + 16 + 2 * (x - 1)));
-      a = _mm_unpacklo_epi8(loadA, loadB);
-      b = _mm_unpackhi_epi8(loadA, loadB);
-      c = _mm_unpacklo_epi8(a, b);
-      d = _mm_unpackhi_epi8(a, b);
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-      __m128i row_2 = _mm_unpacklo_epi8(a, b);
-
-
-      // --------------------------------------------------------------------------------------------------------
-
-      // Now the actual calculations are performed
-      // Since sobel needs a 3 by 3 surrounding of a pixel, we shift the rows to the right, so that
-      // the correct values will be added
-      // for example:
-      // Y0 | Y1 | Y2
-      // Y3 | xx | Y4
-      // Y5 | Y6 | Y7
-      // To calculate the result xx we need to calculate gx = Y0 + Y3 * 2 + Y5 - Y2 - Y4 * 2 - Y7 (divide the whole equation by 4)
-      // To get all these values in the first 8 bits of a register, the shifts are done
-      // i.e. row_0 is shifted 2 Bytes to the right, to get Y2 in the first 8-bit of the register
-      __m128i row_0_shifts_0 = row_0;
-      __m128i row_0_shifts_1 = _mm_srli_si128(row_0, 1);
-      __m128i row_0_shifts_2 = _mm_srli_si128(row_0, 2);
-      __m128i row_1_shifts_0 = row_1;
-      __m128i row_1_shifts_2 = _mm_srli_si128(row_1, 2);
-      __m128i row_2_shifts_0 = row_2;
-      __m128i row_2_shifts_1 = _mm_srli_si128(row_2, 1);
-      __m128i row_2_shifts_2 = _mm_srli_si128(row_2, 2);
-
-      // Divide by 2 or 4 (see above, Y3 and Y4 need to be divided by 2)
-      row_1_shifts_0 = _mm_srli_epi8(row_1_shifts_0, 1);
-      row_1_shifts_2 = _mm_srli_epi8(row_1_shifts_2, 1);
-
-      // Divide by 4
-      row_0_shifts_0 = _mm_srli_epi8(row_0_shifts_0, 2);
-      row_2_shifts_0 = _mm_srli_epi8(row_2_shifts_0, 2);
-      row_2_shifts_2 = _mm_srli_epi8(row_2_shifts_2, 2);
-      row_0_shifts_2 = _mm_srli_epi8(row_0_shifts_2, 2);
-
-      __m128i gx;
-      if (dir == Uni || dir == Horizontal)
-      {
-        // Calculate positiv and negativ sum for X direction
-        __m128i gx_pos = _mm_adds_epu8(row_0_shifts_0, _mm_adds_epu8(row_2_shifts_0, row_1_shifts_0));
-        __m128i gx_neg = _mm_adds_epu8(row_0_shifts_2, _mm_adds_epu8(row_2_shifts_2, row_1_shifts_2));
+    count = std::min(threadPool->getThreadCount(), (args.yEnd - args.yBegin) / minRowsPerBand);
+  }
 
-        // Calulate the absolute difference between the positive and negative sum in X direction
-        gx = _mm_subs_epu8(_mm_max_epu8(gx_pos, gx_neg), _mm_min_epu8(gx_pos, gx_neg));
-      }
+  if (count < 2)
+  {
+    function(args, context, 0);
+    return;
+  }
 
-      __m128i gy;
-      if (dir == Uni || dir == Vertical)
-      {
-        // Same for gy
-        // Multiply by 2 (see above)
-        row_0_shifts_1 = _mm_srli_epi8(row_0_shifts_1, 1);
-        row_2_shifts_1 = _mm_srli_epi8(row_2_shifts_1, 1);
+  SobelBands bands = { function, context, args, count };
+  threadPool->run(count, runBand, &bands);
+}
 
-        __m128i gy_pos = _mm_adds_epu8(row_0_shifts_0, _mm_adds_epu8(row_0_shifts_1, row_0_shifts_2));
-        __m128i gy_neg = _mm_adds_epu8(row_2_shifts_1, _mm_adds_epu8(row_2_shifts_0, row_2_shifts_2));
+/**
+ * @brief Sets the border of the rectangle and with returnFullArray everything outside of it to 0. Only the affected rows and columns are touched.
+ * @param valuesPerPixel Number of consecutive values of the target belonging to one pixel, i.e. 2 for interleaved gradients.
+ * @param radius Width of the border, i.e. the radius of the surrounding of the operator.
+ */
+template<typename T> static void clearBorder(stdVectorView2D<T> target, int startX, int startY, int endX, int endY, int width, int height,
+                                             bool returnFullArray, int valuesPerPixel = 1, int radius = 1)
+{
+  if (!returnFullArray)
+  {
+    // Same as below for the rectangle only
+    width = endX - startX + 1;
+    height = endY - startY + 1;
+    endX -= startX;
+    endY -= startY;
+    startX = 0;
+    startY = 0;
+  }
 
-        gy = _mm_subs_epu8(_mm_max_epu8(gy_pos, gy_neg), _mm_min_epu8(gy_pos, gy_neg));
-      }
+  for (int y = 0; y < height; ++y)
+  {
+    T* row = target.row(y);
+    if (y < startY + radius || y > endY - radius)
+    {
+      std::fill(row, row + width * valuesPerPixel, T(0));
+    }
+    else
+    {
+      // With a radius larger than 1 the border columns of a narrow rectangle overlap
+      const int innerBegin = std::min(startX + radius, width);
+      const int innerEnd = std::max(endX - radius + 1, innerBegin);
+      std::fill(row, row + innerBegin * valuesPerPixel, T(0));
+      std::fill(row + innerEnd * valuesPerPixel, row + width * valuesPerPixel, T(0));
+    }
+  }
+}
 
-      __m128i result;
-      if (dir == Uni)
-      {
-        // The result should be calculated as sqrt( pow(gx,2) + pow(gy,2) )
-        // Since this is really slow and not easily done in 8-Bit because of massive overflow
-        // we gonna approximate this with the "Alpha max plus beta min"-algorithm
-        // with alpha = 1 and beta = 1/4 (since this is only a bitshift for the smaller value)
-        // see for example http://en.wikipedia.org/wiki/Alpha_max_plus_beta_min_algorithm
-        // or http://www.dspguru.com/dsp/tricks/magnitude-estimator
-        __m128i mins = _mm_min_epu8(gx, gy);
-        __m128i maxs = _mm_max_epu8(gx, gy);
-        mins = _mm_srli_epi8(mins, 2);
-        result = _mm_adds_epu8(mins, maxs);
-      }
-      else if (dir == Horizontal)
-      {
-        result = gx;
-      }
-      else
-      {
-        result = gy;
-      }
 
-      // Store the result
-      if (returnFullArray)
+/**
+ * @brief Returns the index of a row or column of the image, replacing indices outside of the image as given by the border policy.
+ */
+static int borderIndex(int i, int size, bool mirror)
+{
+  // An image of a single row or column has nothing to mirror
+  if (size == 1)
+  {
+    return 0;
+  }
+  if (i < 0)
+  {
+    return mirror ? -i : 0;
+  }
+  if (i >= size)
+  {
+    return mirror ? 2 * size - 2 - i : size - 1;
+  }
+  return i;
+}
+
+/**
+ * @brief Returns the Y value of the pixel (x, y) of the (full or quarter) image, which has to be inside the image.
+ * @param quarter Whether the coordinates are in the quarter image.
+ */
+static unsigned char readY(const SobelKernelArgs& args, bool quarter, int x, int y)
+{
+  // Only UYVY does not start with a Y value
+  const int columnBytes = bytesPerColumn(args.format, quarter);
+  const unsigned char* p = args.image + (args.format == SobelDortmund::UYVY ? 1 : 0) + y * args.rowStride + x * columnBytes;
+  if (quarter && args.quarterSampling == SobelDortmund::BoxAverage)
+  {
+    const int right = columnBytes / 2;
+    const int below = args.rowStride / 2;
+    return static_cast<unsigned char>((p[0] + p[right] + p[below] + p[below + right] + 2) >> 2);
+  }
+  return *p;
+}
+
+/**
+ * @brief Calculates the pixels of the rectangle, whose 3x3 surrounding is not inside the image. There are only a few of them, so this is done
+ * pixel by pixel with the scalar traits, which give the same results as the kernels.
+ * @param args The kernel arguments of the rectangle, whose target is where the result of pixel (startX, startY) is stored.
+ * @param quarter Whether the coordinates are in the quarter image.
+ */
+static void calculateImageBorder(const SobelKernelArgs& args, bool quarter, int startX, int startY, int endX, int endY, int width, int height,
+                                 bool mirror)
+{
+  for (int y = startY; y <= endY; ++y)
+  {
+    const bool borderRow = y == 0 || y == height - 1;
+    for (int x = startX; x <= endX; ++x)
+    {
+      if (!borderRow && x != 0 && x != width - 1)
       {
-        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + x + y * width), result);
+        // Jump to the last column of the rectangle, which might be at the border
+        x = std::max(x, endX - 1);
+        continue;
       }
-      else
+
+      unsigned char surrounding[3][3];
+      for (int i = 0; i < 3; ++i)
       {
-        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + x - startX + (y - startY) * rectWidth), result);
+        for (int j = 0; j < 3; ++j)
+        {
+          surrounding[i][j] = readY(args, quarter, borderIndex(x + j - 1, width, mirror), borderIndex(y + i - 1, height, mirror));
+        }
       }
+      args.target[(y - startY) * args.targetStride + x - startX] = sobelStep<SobelScalar>(surrounding[0], surrounding[1], surrounding[2], args.dir);
     }
-    // Increase the row pointers
-    row_0_ptr += 2 * width;
-    row_1_ptr += 2 * width;
-    row_2_ptr += 2 * width;
+  }
+}
+
+/**
+ * @brief Calculates the sobel result of a rectangle of the (full or quarter) image, handling its border as given by the border policy.
+ * @param quarter Whether the coordinates are in the quarter image.
+ */
+static void calculateSobel(SobelBandFunction function, const SobelDortmund::InputImage& image, bool quarter,
+                           int startX, int startY, int endX, int endY, int width, int height, stdVectorView2D<unsigned char> target,
+                           SobelDortmund::Direction dir, bool returnFullArray, SobelDortmund::BorderPolicy border)
+{
+  if (border != SobelDortmund::BorderUntouched)
+  {
+    clearBorder(target, startX, startY, endX, endY, width, height, returnFullArray);
+  }
+
+  // With returnFullArray the result is written at image coordinates, otherwise relative to the rectangle
+  SobelKernelArgs args = makeKernelArgs(image, quarter, width, startX, startY, endX, endY, dir);
+  args.target = returnFullArray ? &target(startX, startY) : target.data();
+  args.targetStride = target.getStride();
+
+  const bool calculateBorder = border == SobelDortmund::BorderReplicate || border == SobelDortmund::BorderMirror;
+  if (calculateBorder)
+  {
+    // The kernel calculates the border of the rectangle as well, wherever the surrounding is inside the image
+    args.xBegin = std::max(startX, 1);
+    args.xEnd = std::min(endX + 1, width - 1);
+    args.yBegin = std::max(startY, 1);
+    args.yEnd = std::min(endY + 1, height - 1);
+  }
+  if (args.xBegin < args.xEnd && args.yBegin < args.yEnd)
+  {
+    runBands(function, nullptr, args);
+  }
+
+  if (calculateBorder)
+  {
+    calculateImageBorder(args, quarter, startX, startY, endX, endY, width, height, border == SobelDortmund::BorderMirror);
+  }
+}
+
+const stdVector2D<unsigned char> SobelDortmund::sobelSSEAnyYUVImageFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                                  Direction dir, bool returnFullArray, BorderPolicy border)
+{
+  switchStartEnd(startX, startY, endX, endY);
+
+  stdVector2D<unsigned char> targetData = returnFullArray ? stdVector2D<unsigned char>(width, height)
+                                                          : stdVector2D<unsigned char>(endX - startX + 1, endY - startY + 1);
+  sobelSSEAnyYUVImageFull(YUVImage, startX, startY, endX, endY, width, height, targetData.view(), dir, returnFullArray, border);
+
+  return targetData;
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                            stdVectorView2D<unsigned char> target, Direction dir, bool returnFullArray, BorderPolicy border)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageFull", (endX - startX + 1) * (endY - startY + 1));
+  calculateSobel(runFullBand, YUVImage, false, startX, startY, endX, endY, width, height, target, dir, returnFullArray, border);
+}
+
+const stdVector2D<unsigned char> SobelDortmund::sobelSSEAnyYUVImageQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                                     Direction dir, bool returnFullArray, BorderPolicy border)
+{
+  switchStartEnd(startX, startY, endX, endY);
+
+  stdVector2D<unsigned char> targetData = returnFullArray ? stdVector2D<unsigned char>(width, height)
+                                                          : stdVector2D<unsigned char>(endX - startX + 1, endY - startY + 1);
+  sobelSSEAnyYUVImageQuarter(YUVImage, startX, startY, endX, endY, width, height, targetData.view(), dir, returnFullArray, border);
+
+  return targetData;
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                               stdVectorView2D<unsigned char> target, Direction dir, bool returnFullArray, BorderPolicy border)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageQuarter", (endX - startX + 1) * (endY - startY + 1));
+  calculateSobel(runQuarterBand, YUVImage, true, startX, startY, endX, endY, width, height, target, dir, returnFullArray, border);
+}
+
+
+void SobelDortmund::sobelSSEAnyYUVImageGradientsFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                     stdVectorView2D<short> gx, stdVectorView2D<short> gy, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageGradientsFull", (endX - startX + 1) * (endY - startY + 1));
+
+  SobelGradientArgs gradients;
+  gradients.gx = returnFullArray ? &gx(startX, startY) : gx.data();
+  gradients.gxStride = gx.getStride();
+  gradients.gy = returnFullArray ? &gy(startX, startY) : gy.data();
+  gradients.gyStride = gy.getStride();
+  gradients.originX = startX;
+  gradients.originY = startY;
+  runBands(runGradientFullBand, &gradients, makeKernelArgs(YUVImage, false, width, startX, startY, endX, endY, Uni));
+
+  clearBorder(gx, startX, startY, endX, endY, width, height, returnFullArray);
+  clearBorder(gy, startX, startY, endX, endY, width, height, returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageGradientsFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                     stdVectorView2D<short> gxy, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageGradientsFull", (endX - startX + 1) * (endY - startY + 1));
+
+  SobelGradientArgs gradients;
+  gradients.gx = returnFullArray ? &gxy(2 * startX, startY) : gxy.data();
+  gradients.gxStride = gxy.getStride();
+  gradients.gy = nullptr;
+  gradients.gyStride = 0;
+  gradients.originX = startX;
+  gradients.originY = startY;
+  runBands(runGradientFullBand, &gradients, makeKernelArgs(YUVImage, false, width, startX, startY, endX, endY, Uni));
+
+  clearBorder(gxy, startX, startY, endX, endY, width, height, returnFullArray, 2);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageGradientsQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                        stdVectorView2D<short> gx, stdVectorView2D<short> gy, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageGradientsQuarter", (endX - startX + 1) * (endY - startY + 1));
+
+  SobelGradientArgs gradients;
+  gradients.gx = returnFullArray ? &gx(startX, startY) : gx.data();
+  gradients.gxStride = gx.getStride();
+  gradients.gy = returnFullArray ? &gy(startX, startY) : gy.data();
+  gradients.gyStride = gy.getStride();
+  gradients.originX = startX;
+  gradients.originY = startY;
+  runBands(runGradientQuarterBand, &gradients, makeKernelArgs(YUVImage, true, width, startX, startY, endX, endY, Uni));
+
+  clearBorder(gx, startX, startY, endX, endY, width, height, returnFullArray);
+  clearBorder(gy, startX, startY, endX, endY, width, height, returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageGradientsQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                        stdVectorView2D<short> gxy, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageGradientsQuarter", (endX - startX + 1) * (endY - startY + 1));
+
+  SobelGradientArgs gradients;
+  gradients.gx = returnFullArray ? &gxy(2 * startX, startY) : gxy.data();
+  gradients.gxStride = gxy.getStride();
+  gradients.gy = nullptr;
+  gradients.gyStride = 0;
+  gradients.originX = startX;
+  gradients.originY = startY;
+  runBands(runGradientQuarterBand, &gradients, makeKernelArgs(YUVImage, true, width, startX, startY, endX, endY, Uni));
+
+  clearBorder(gxy, startX, startY, endX, endY, width, height, returnFullArray, 2);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageOrientationFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                       stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> orientation,
+                                                       Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageOrientationFull", (endX - startX + 1) * (endY - startY + 1));
+
+  SobelKernelArgs args = makeKernelArgs(YUVImage, false, width, startX, startY, endX, endY, dir);
+  args.target = returnFullArray ? &magnitude(startX, startY) : magnitude.data();
+  args.targetStride = magnitude.getStride();
+
+  SobelOrientationArgs orientationArgs;
+  orientationArgs.orientation = returnFullArray ? &orientation(startX, startY) : orientation.data();
+  orientationArgs.orientationStride = orientation.getStride();
+  runBands(runOrientationFullBand, &orientationArgs, args);
+
+  clearBorder(magnitude, startX, startY, endX, endY, width, height, returnFullArray);
+  clearBorder(orientation, startX, startY, endX, endY, width, height, returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageOrientationQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                          stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> orientation,
+                                                          Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageOrientationQuarter", (endX - startX + 1) * (endY - startY + 1));
+
+  SobelKernelArgs args = makeKernelArgs(YUVImage, true, width, startX, startY, endX, endY, dir);
+  args.target = returnFullArray ? &magnitude(startX, startY) : magnitude.data();
+  args.targetStride = magnitude.getStride();
+
+  SobelOrientationArgs orientationArgs;
+  orientationArgs.orientation = returnFullArray ? &orientation(startX, startY) : orientation.data();
+  orientationArgs.orientationStride = orientation.getStride();
+  runBands(runOrientationQuarterBand, &orientationArgs, args);
+
+  clearBorder(magnitude, startX, startY, endX, endY, width, height, returnFullArray);
+  clearBorder(orientation, startX, startY, endX, endY, width, height, returnFullArray);
+}
+
+/**
+ * @brief Calculates a rectangle with a kernel whose surrounding reaches radius pixels in every direction, so the border of the rectangle
+ * is radius pixels wide.
+ * @param context Additional arguments of the kernel, passed to the band function.
+ * @param quarter Whether the coordinates are in the quarter image.
+ */
+static void calculateWithBorder(SobelBandFunction function, const void* context, int radius, const SobelDortmund::InputImage& image,
+                                bool quarter, int startX, int startY, int endX, int endY, int width, int height,
+                                stdVectorView2D<unsigned char> target, SobelDortmund::Direction dir, bool returnFullArray)
+{
+  SobelKernelArgs args = makeKernelArgs(image, quarter, width, startX, startY, endX, endY, dir);
+  args.xBegin = startX + radius;
+  args.xEnd = endX - radius + 1;
+  args.yBegin = startY + radius;
+  args.yEnd = endY - radius + 1;
+  args.target = returnFullArray ? &target(startX, startY) : target.data();
+  args.targetStride = target.getStride();
+  if (args.xBegin < args.xEnd && args.yBegin < args.yEnd)
+  {
+    runBands(function, context, args);
+  }
+
+  clearBorder(target, startX, startY, endX, endY, width, height, returnFullArray, 1, radius);
+}
+
+// Radius of the surrounding of a gradient operator
+static int operatorRadius(SobelDortmund::Operator op)
+{
+  return op == SobelDortmund::Sobel5x5 ? 2 : 1;
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageOperatorFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                    stdVectorView2D<unsigned char> target, Operator op, Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageOperatorFull", (endX - startX + 1) * (endY - startY + 1));
+  calculateWithBorder(runOperatorFullBand, &op, operatorRadius(op), YUVImage, false, startX, startY, endX, endY, width, height, target, dir,
+                      returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageOperatorQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                       stdVectorView2D<unsigned char> target, Operator op, Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageOperatorQuarter", (endX - startX + 1) * (endY - startY + 1));
+  calculateWithBorder(runOperatorQuarterBand, &op, operatorRadius(op), YUVImage, true, startX, startY, endX, endY, width, height, target, dir,
+                      returnFullArray);
+}
+
+// Radius of the surrounding of the sobel operator on the smoothed Y values
+static int smoothingRadius(SobelDortmund::Smoothing smoothing)
+{
+  return smoothing == SobelDortmund::Gaussian5x5 ? 3 : smoothing == SobelDortmund::Gaussian3x3 ? 2 : 1;
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageSmoothedFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                    stdVectorView2D<unsigned char> target, Smoothing smoothing, Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageSmoothedFull", (endX - startX + 1) * (endY - startY + 1));
+  calculateWithBorder(runSmoothedFullBand, &smoothing, smoothingRadius(smoothing), YUVImage, false, startX, startY, endX, endY, width, height,
+                      target, dir, returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageSmoothedQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                       stdVectorView2D<unsigned char> target, Smoothing smoothing, Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageSmoothedQuarter", (endX - startX + 1) * (endY - startY + 1));
+  calculateWithBorder(runSmoothedQuarterBand, &smoothing, smoothingRadius(smoothing), YUVImage, true, startX, startY, endX, endY, width, height,
+                      target, dir, returnFullArray);
+}
+
+/**
+ * @brief Calculates the sobel result of a rectangle and the statistics of its tiles with the thread pool.
+ * @param quarter Whether the coordinates are in the quarter image.
+ */
+static void calculateStatistics(SobelBandFunction function, const SobelDortmund::InputImage& image, bool quarter,
+                                int startX, int startY, int endX, int endY, int width, int height, stdVectorView2D<unsigned char> target,
+                                std::vector<SobelDortmund::TileStatistics>& statistics, int tileSize, unsigned char threshold,
+                                SobelDortmund::Direction dir, bool returnFullArray)
+{
+  const SobelDortmund::TileStatistics empty = {};
+  const int tilesX = (endX - startX + tileSize) / tileSize;
+  const int tilesY = (endY - startY + tileSize) / tileSize;
+  statistics.assign(tilesX * tilesY, empty);
+
+  // The tiles of the other bands, kept per thread so their memory is reused by the next call
+  static thread_local std::vector<std::vector<SobelDortmund::TileStatistics>> bandTiles;
+  const int threads = SobelDortmund::getThreadCount();
+  if (static_cast<int>(bandTiles.size()) < threads - 1)
+  {
+    bandTiles.resize(threads - 1);
+  }
+  for (size_t i = 0; i < bandTiles.size(); ++i)
+  {
+    bandTiles[i].assign(statistics.size(), empty);
   }
 
+  SobelKernelArgs args = makeKernelArgs(image, quarter, width, startX, startY, endX, endY, dir);
+  args.target = returnFullArray ? &target(startX, startY) : target.data();
+  args.targetStride = target.getStride();
 
-  if (returnFullArray)
+  SobelStatisticsBands bands;
+  bands.statistics.tiles = statistics.data();
+  bands.statistics.tilesX = tilesX;
+  bands.statistics.tileSize = tileSize;
+  bands.statistics.threshold = threshold;
+  bands.bandTiles = bandTiles.data();
+  runBands(function, &bands, args);
+
+  for (size_t i = 0; i < statistics.size(); ++i)
   {
-    for (int i = 0; i < height; ++i)
+    SobelDortmund::TileStatistics& tile = statistics[i];
+    for (size_t band = 0; band < bandTiles.size(); ++band)
     {
-      for (int j = 0; j < width; ++j)
+      const SobelDortmund::TileStatistics& bandTile = bandTiles[band][i];
+      tile.pixels += bandTile.pixels;
+      tile.count += bandTile.count;
+      tile.sum += bandTile.sum;
+      tile.max = std::max(tile.max, bandTile.max);
+      for (int bin = 0; bin < SobelDortmund::histogramBins; ++bin)
       {
-        if (j <= startX || j >= endX - 1 || i <= startY || i >= endY - 1)
-        {
-          target[i * width + j] = 2; // Set edge pixels to 0
-        }
+        tile.histogram[bin] += bandTile.histogram[bin];
       }
     }
+    sobelStatisticsBins(tile);
   }
-  else
+
+  clearBorder(target, startX, startY, endX, endY, width, height, returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageStatisticsFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                      stdVectorView2D<unsigned char> target, std::vector<TileStatistics>& statistics, int tileSize,
+                                                      unsigned char threshold, Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageStatisticsFull", (endX - startX + 1) * (endY - startY + 1));
+  calculateStatistics(runStatisticsFullBand, YUVImage, false, startX, startY, endX, endY, width, height, target, statistics, tileSize, threshold,
+                      dir, returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageStatisticsQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                         stdVectorView2D<unsigned char> target, std::vector<TileStatistics>& statistics, int tileSize,
+                                                         unsigned char threshold, Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageStatisticsQuarter", (endX - startX + 1) * (endY - startY + 1));
+  calculateStatistics(runStatisticsQuarterBand, YUVImage, true, startX, startY, endX, endY, width, height, target, statistics, tileSize, threshold,
+                      dir, returnFullArray);
+}
+
+/**
+ * @brief Calculates the sobel result of the Y values and in the same pass those of the U and V values into u and v or, if v has no data,
+ * their combined color edge strength into u.
+ * @param quarter Whether the coordinates are in the quarter image, whose pixels are the pixel pairs. Otherwise a pixel pair is two columns.
+ */
+static void calculateChroma(SobelBandFunction function, const SobelDortmund::InputImage& image, bool quarter,
+                            int startX, int startY, int endX, int endY, int width, int height, stdVectorView2D<unsigned char> magnitude,
+                            stdVectorView2D<unsigned char> u, stdVectorView2D<unsigned char> v, SobelDortmund::Direction dir, bool returnFullArray)
+{
+  // The rectangle of the pixel pairs, only complete pairs have a V value
+  const int chromaWidth = quarter ? width : width / 2;
+  int chromaStartX = quarter ? startX : startX / 2;
+  int chromaEndX = quarter ? endX : std::min(endX / 2, chromaWidth - 1);
+  const bool chromaEmpty = chromaStartX > chromaEndX;
+
+  SobelKernelArgs args = makeKernelArgs(image, quarter, width, startX, startY, endX, endY, dir);
+  args.target = returnFullArray ? &magnitude(startX, startY) : magnitude.data();
+  args.targetStride = magnitude.getStride();
+
+  SobelChromaArgs chroma;
+  chroma.u = returnFullArray && !chromaEmpty ? &u(chromaStartX, startY) : u.data();
+  chroma.uStride = u.getStride();
+  chroma.v = !v.data() ? nullptr : returnFullArray && !chromaEmpty ? &v(chromaStartX, startY) : v.data();
+  chroma.vStride = v.getStride();
+  chroma.xBegin = chromaStartX + 1;
+  chroma.xEnd = chromaEmpty ? chroma.xBegin : chromaEndX;
+  chroma.originX = chromaStartX;
+  runBands(function, &chroma, args);
+
+  clearBorder(magnitude, startX, startY, endX, endY, width, height, returnFullArray);
+  if (chromaEmpty)
   {
-    for (int i = 0; i < rectHeight; ++i)
+    // The rectangle lies in the last column of an image of odd width, which is not a complete pair. So the chroma results are all outside of it.
+    chromaStartX = 0;
+    chromaEndX = -1;
+    startY = height;
+    endY = height;
+    if (!returnFullArray)
     {
-      target[i * (rectWidth)] = 0;          // Set left edge to 0
-      target[(i + 1) * (rectWidth)-1] = 0;  // Set right edge to 0
-    }
-    for (int j = 0; j < rectWidth; ++j)
-    {
-      target[j] = 0;                                   // Set top edge to 0
-      target[(rectHeight - 1) * (rectWidth) + j] = 0;  // Set bottom edge to 0
+      return;
     }
   }
+  clearBorder(u, chromaStartX, startY, chromaEndX, endY, chromaWidth, height, returnFullArray);
+  if (chroma.v)
+  {
+    clearBorder(v, chromaStartX, startY, chromaEndX, endY, chromaWidth, height, returnFullArray);
+  }
+}
 
-  return targetData;
+void SobelDortmund::sobelSSEAnyYUVImageChromaFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                  stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> u, stdVectorView2D<unsigned char> v,
+                                                  Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageChromaFull", (endX - startX + 1) * (endY - startY + 1));
+  calculateChroma(runChromaFullBand, YUVImage, false, startX, startY, endX, endY, width, height, magnitude, u, v, dir, returnFullArray);
 }
 
-const stdVector2D<unsigned char> SobelDortmund::sobelSSEAnyYUVImageQuarter(const unsigned char* YUVImage, int startX, int startY, int endX, int endY, int width, int height,
-                                                                     Direction dir, bool returnFullArray)
+void SobelDortmund::sobelSSEAnyYUVImageChromaFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                  stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> color,
+                                                  Direction dir, bool returnFullArray)
 {
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageChromaFull", (endX - startX + 1) * (endY - startY + 1));
+  calculateChroma(runChromaFullBand, YUVImage, false, startX, startY, endX, endY, width, height, magnitude, color,
+                  stdVectorView2D<unsigned char>(nullptr, 0, 0), dir, returnFullArray);
+}
 
+void SobelDortmund::sobelSSEAnyYUVImageChromaQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                     stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> u, stdVectorView2D<unsigned char> v,
+                                                     Direction dir, bool returnFullArray)
+{
   switchStartEnd(startX, startY, endX, endY);
-  int rectWidth = endX - startX + 1;
-  int rectHeight = endY - startY + 1;
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageChromaQuarter", (endX - startX + 1) * (endY - startY + 1));
+  calculateChroma(runChromaQuarterBand, YUVImage, true, startX, startY, endX, endY, width, height, magnitude, u, v, dir, returnFullArray);
+}
 
-  stdVector2D<unsigned char> targetData(rectHeight, rectWidth);
-  if (returnFullArray)
+void SobelDortmund::sobelSSEAnyYUVImageChromaQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                     stdVectorView2D<unsigned char> magnitude, stdVectorView2D<unsigned char> color,
+                                                     Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageChromaQuarter", (endX - startX + 1) * (endY - startY + 1));
+  calculateChroma(runChromaQuarterBand, YUVImage, true, startX, startY, endX, endY, width, height, magnitude, color,
+                  stdVectorView2D<unsigned char>(nullptr, 0, 0), dir, returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageCannyFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                 stdVectorView2D<unsigned char> edges, unsigned char lowThreshold, unsigned char highThreshold,
+                                                 bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageCannyFull", (endX - startX + 1) * (endY - startY + 1));
+
+  SobelKernelArgs args = makeKernelArgs(YUVImage, false, width, startX, startY, endX, endY, Uni);
+  args.target = returnFullArray ? &edges(startX, startY) : edges.data();
+  args.targetStride = edges.getStride();
+  sobelCannyFullKernel<SobelBaseline>(args, lowThreshold, highThreshold);
+
+  clearBorder(edges, startX, startY, endX, endY, width, height, returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageCannyQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                    stdVectorView2D<unsigned char> edges, unsigned char lowThreshold, unsigned char highThreshold,
+                                                    bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageCannyQuarter", (endX - startX + 1) * (endY - startY + 1));
+
+  SobelKernelArgs args = makeKernelArgs(YUVImage, true, width, startX, startY, endX, endY, Uni);
+  args.target = returnFullArray ? &edges(startX, startY) : edges.data();
+  args.targetStride = edges.getStride();
+  sobelCannyQuarterKernel<SobelBaseline>(args, lowThreshold, highThreshold);
+
+  clearBorder(edges, startX, startY, endX, endY, width, height, returnFullArray);
+}
+
+/**
+ * @brief Collects the edge points of the inner pixels of args with the thread pool.
+ */
+static void runEdgePointBands(SobelBandFunction function, const SobelKernelArgs& args, std::vector<SobelDortmund::EdgePoint>& points,
+                              unsigned char threshold, bool withGradients)
+{
+  // The points of the other bands, kept per thread so their memory is reused by the next call
+  static thread_local std::vector<std::vector<SobelDortmund::EdgePoint>> bandPoints;
+  const int threads = SobelDortmund::getThreadCount();
+  if (static_cast<int>(bandPoints.size()) < threads - 1)
   {
-      targetData.resize(width*height);
-      targetData.setWidth(width);
-      targetData.setHeight(height);
+    bandPoints.resize(threads - 1);
+  }
+  for (size_t i = 0; i < bandPoints.size(); ++i)
+  {
+    bandPoints[i].clear();
   }
 
+  points.clear();
+  SobelEdgePointBands bands;
+  bands.edgePoints.points = &points;
+  bands.edgePoints.threshold = threshold;
+  bands.edgePoints.withGradients = withGradients;
+  bands.bandPoints = bandPoints.data();
+  runBands(function, &bands, args);
 
+  for (size_t i = 0; i < bandPoints.size(); ++i)
+  {
+    points.insert(points.end(), bandPoints[i].begin(), bandPoints[i].end());
+  }
+}
 
-  unsigned char* target = targetData.data();
+void SobelDortmund::sobelSSEAnyYUVImageEdgePointsFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                      std::vector<EdgePoint>& points, unsigned char threshold, bool withGradients, Direction dir)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  // Without a target there is nothing to bound the rectangle, so it is clipped to the image
+  endX = std::min(endX, width - 1);
+  endY = std::min(endY, height - 1);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageEdgePointsFull", (endX - startX + 1) * (endY - startY + 1));
+  runEdgePointBands(runEdgePointFullBand, makeKernelArgs(YUVImage, false, width, startX, startY, endX, endY, dir), points, threshold, withGradients);
+}
 
-  // Calculate the pointers to the first element of the first 3 rows using pointer arithmetic
-  const unsigned char* row_0_ptr = YUVImage + startY * width * 8;
-  const unsigned char* row_1_ptr = row_0_ptr + 8 * width;
-  const unsigned char* row_2_ptr = row_0_ptr + 16 * width;
+void SobelDortmund::sobelSSEAnyYUVImageEdgePointsFull(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                      std::vector<EdgePoint>& points, unsigned char threshold, stdVectorView2D<unsigned char> target,
+                                                      bool withGradients, Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageEdgePointsFull", (endX - startX + 1) * (endY - startY + 1));
 
-  int i = 1;
-  int j = 1;
+  SobelKernelArgs args = makeKernelArgs(YUVImage, false, width, startX, startY, endX, endY, dir);
+  args.target = returnFullArray ? &target(startX, startY) : target.data();
+  args.targetStride = target.getStride();
+  runEdgePointBands(runEdgePointFullBand, args, points, threshold, withGradients);
 
-  if (returnFullArray)
+  clearBorder(target, startX, startY, endX, endY, width, height, returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageEdgePointsQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                         std::vector<EdgePoint>& points, unsigned char threshold, bool withGradients, Direction dir)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  // Without a target there is nothing to bound the rectangle, so it is clipped to the image
+  endX = std::min(endX, width - 1);
+  endY = std::min(endY, height - 1);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageEdgePointsQuarter", (endX - startX + 1) * (endY - startY + 1));
+  runEdgePointBands(runEdgePointQuarterBand, makeKernelArgs(YUVImage, true, width, startX, startY, endX, endY, dir), points, threshold, withGradients);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageEdgePointsQuarter(const InputImage& YUVImage, int startX, int startY, int endX, int endY, int width, int height,
+                                                         std::vector<EdgePoint>& points, unsigned char threshold, stdVectorView2D<unsigned char> target,
+                                                         bool withGradients, Direction dir, bool returnFullArray)
+{
+  switchStartEnd(startX, startY, endX, endY);
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageEdgePointsQuarter", (endX - startX + 1) * (endY - startY + 1));
+
+  SobelKernelArgs args = makeKernelArgs(YUVImage, true, width, startX, startY, endX, endY, dir);
+  args.target = returnFullArray ? &target(startX, startY) : target.data();
+  args.targetStride = target.getStride();
+  runEdgePointBands(runEdgePointQuarterBand, args, points, threshold, withGradients);
+
+  clearBorder(target, startX, startY, endX, endY, width, height, returnFullArray);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImagePyramid(const InputImage& YUVImage, int width, int height, stdVectorView2D<unsigned char> level1,
+                                               stdVectorView2D<unsigned char> level2, stdVectorView2D<unsigned char> level3, Direction dir)
+{
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImagePyramid", (width / 2) * (height / 2));
+  stdVectorView2D<unsigned char> targets[sobelPyramidLevels] = { level1, level2, level3 };
+  SobelKernelArgs levels[sobelPyramidLevels];
+
+  // The first level is only half as wide as the image rounded down, so the row stride has to be taken from the full width
+  InputImage image = YUVImage;
+  if (image.rowStride <= 0)
+  {
+    image.rowStride = bytesPerColumn(image.format, false) * width;
+  }
+  for (int level = 0; level < sobelPyramidLevels; ++level)
   {
-    i = startY + 1;
+    width /= 2;
+    height /= 2;
+    if (width > 0 && height > 0)
+    {
+      clearBorder(targets[level], 0, 0, width - 1, height - 1, width, height, true);
+    }
+
+    // The input image of the other levels is the ring of sobelPyramidKernel, so only their size and target are used
+    levels[level] = makeKernelArgs(image, true, width, 0, 0, width - 1, height - 1, dir);
+    levels[level].target = targets[level].data();
+    levels[level].targetStride = targets[level].getStride();
   }
 
-  // Main Loop, we will start at +1 because Sobel needs a 3x3 surrounding, which is
-  // not available for edge pixels
-  // Every row will be looped through, but only every 2*14th column, because with 8 bit SSE
-  // it is possible to store 16 8-bit values in one SSE register, which will give 14 results, also we are processing the quarter image
-  for (int y = startY + 1; y < endY; y++)
+  // Only a few rows per level are kept, which are reused by every call on this thread
+  static thread_local std::vector<unsigned char> rows;
+  const int rowSize = levels[0].xEnd + 1 + SobelBaseline::size;
+  rows.resize(4 * sobelPyramidLevels * rowSize);
+  sobelPyramidKernel<SobelBaseline>(levels, rows.data(), rowSize);
+}
+
+// Values behind the Y values of every row of the ring of a stream, the stencil of the widest instruction set reads up to 64 values behind the row
+static const int sobelStreamPadding = 64;
+
+SobelDortmund::Stream::Stream(int width, int height, stdVectorView2D<unsigned char> target, PixelFormat format, Direction dir)
+  : width(width), height(height), target(target), format(format), dir(dir), pushedRows(0), ring(3 * (width + sobelStreamPadding))
+{
+}
+
+void SobelDortmund::Stream::reset()
+{
+  pushedRows = 0;
+}
+
+int SobelDortmund::Stream::push(const unsigned char* rows, int count, int rowStride)
+{
+  SOBEL_INSTRUMENT("Stream::push", std::min(count, height - pushedRows) * width);
+  if (rowStride <= 0)
   {
-    if (returnFullArray)
+    rowStride = format == Y8 ? width : 2 * width;
+  }
+
+  const int rowSize = width + sobelStreamPadding;
+  for (int i = 0; i < count && pushedRows < height; ++i)
+  {
+    const int y = pushedRows++;
+
+    // The ring slots of the rows y - 2, y - 1 and y
+    SobelStreamArgs args;
+    args.source = rows + i * rowStride;
+    args.format = format;
+    args.width = width;
+    args.dir = dir;
+    for (int j = 0; j < 3; ++j)
     {
-      j = startX + 1;
+      args.rows[j] = ring.data() + (y + 1 + j) % 3 * rowSize;
     }
-    else
+    args.target = y >= 2 ? target.row(y - 1) : nullptr;
+    kernels().stream(args);
+
+    // The border of the image
+    if (y >= 2)
     {
-      j = 1;
+      target(0, y - 1) = 0;
+      target(width - 1, y - 1) = 0;
     }
-    for (int x = startX * 2 + 1; x <= endX * 2; x += 28)
+    if (y == 0 || y == height - 1)
     {
-      // Now we need to load 16 Y values per row into 1 register
-      // This is done with SSE unpack, which works as in the following example:
-      // Pointer a: a0, a1, a3, ... , a15 | Pointer b: b0, b1, b3, ... , b15 (each value ai/bi has the size 1 Byte)
-      // _mm_unpacklo_epi8(a,b) will result in a register with the 16 8-Bit values: a0, b0, a1, b1, ... , a7, b7
-      // _mm_unpackhi_epi8(a,b) will result in a register with the 16 8-Bit values: a8, b8, a9, b9, ... , a15, b15
-
-      // We want to use these unpack operations to deinterlace our YUV422 array, so that we will have two registers
-      // one containing all the Y values in correct order and the other one containing all U and V values
-
-      // --------------------------------------------------------------------------------------------------------
-
-      // The following commands will deinterlace the Y values for the first row:
-      // Let the YUV422 array be: Y0, U0, Y1, V0, Y2, U1, Y3, V1, Y4, U2, Y5, V2, ...
-      // Unpack the first 16 Values with the second 16 values into a (lo)
-      // This will result in a = Y0, Y8, U0, U4, Y1, Y9, V0, V4, ...
-      // likewise b will be (hi): Y5, Y12, U2, U6, Y5, Y13, V2, V6, ...
-
-      // The pointer will need an offset of 2 * (x-1)
-      // -1: because we started this loop with x = 1
-      // 2 * : because only every second value is a Y value
-
-      // This is the versions for a quarter image, so 4 times 16 values will contain 32 Y values from which we only want to use half
-      __m128i loadA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_0_ptr + 2 * (x - 1)));
-      __m128i loadB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_0_ptr + 16 + 2 * (x - 1)));
-      __m128i loadC = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_0_ptr + 32 + 2 * (x - 1)));
-      __m128i loadD = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_0_ptr + 48 + 2 * (x - 1)));
-
-      __m128i a = _mm_unpacklo_epi8(loadA, loadB);
-      __m128i b = _mm_unpackhi_epi8(loadA, loadB);
-      __m128i c = _mm_unpacklo_epi8(a, b);
-      __m128i d = _mm_unpackhi_epi8(a, b);
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-      __m128i row_0_part_1 = _mm_unpacklo_epi8(a, b);
-
-      a = _mm_unpacklo_epi8(loadC, loadD);
-      b = _mm_unpackhi_epi8(loadC, loadD);
-      c = _mm_unpacklo_epi8(a, b);
-      d = _mm_unpackhi_epi8(a, b);
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-      __m128i row_0_part_2 = _mm_unpacklo_epi8(a, b);
-
-      a = _mm_unpacklo_epi8(row_0_part_1, row_0_part_2);
-      b = _mm_unpackhi_epi8(row_0_part_1, row_0_part_2);
-      c = _mm_unpacklo_epi8(a, b);
-      d = _mm_unpackhi_epi8(a, b);
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-      __m128i row_0 = _mm_unpacklo_epi8(a, b);
-
-      // Same as above for second row
-      loadA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_1_ptr + 2 * (x - 1)));
-      loadB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_1_ptr + 16 + 2 * (x - 1)));
-      loadC = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_1_ptr + 32 + 2 * (x - 1)));
-      loadD = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_1_ptr + 48 + 2 * (x - 1)));
-      a = _mm_unpacklo_epi8(loadA, loadB);
-      b = _mm_unpackhi_epi8(loadA, loadB);
-      c = _mm_unpacklo_epi8(a, b);
-      d = _mm_unpackhi_epi8(a, b);
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-      __m128i row_1_part_1 = _mm_unpacklo_epi8(a, b);
-
-      a = _mm_unpacklo_epi8(loadC, loadD);
-      b = _mm_unpackhi_epi8(loadC, loadD);
-      c = _mm_unpacklo_epi8(a, b);
-      d = _mm_unpackhi_epi8(a, b);
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-      __m128i row_1_part_2 = _mm_unpacklo_epi8(a, b);
-
-      a = _mm_unpacklo_epi8(row_1_part_1, row_1_part_2);
-      b = _mm_unpackhi_epi8(row_1_part_1, row_1_part_2);
-
-      c = _mm_unpacklo_epi8(a, b);
-      d = _mm_unpackhi_epi8(a, b);
-
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-
-      __m128i row_1 = _mm_unpacklo_epi8(a, b);
-
-
-      // Same as above for third row
-      loadA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_2_ptr + 2 * (x - 1)));
-      loadB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_2_ptr + 16 + 2 * (x - 1)));
-      loadC = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_2_ptr + 32 + 2 * (x - 1)));
-      loadD = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_2_ptr + 48 + 2 * (x - 1)));
-      a = _mm_unpacklo_epi8(loadA, loadB);
-      b = _mm_unpackhi_epi8(loadA, loadB);
-      c = _mm_unpacklo_epi8(a, b);
-      d = _mm_unpackhi_epi8(a, b);
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-      __m128i row_2_part_1 = _mm_unpacklo_epi8(a, b);
-
-      a = _mm_unpacklo_epi8(loadC, loadD);
-      b = _mm_unpackhi_epi8(loadC, loadD);
-      c = _mm_unpacklo_epi8(a, b);
-      d = _mm_unpackhi_epi8(a, b);
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-      __m128i row_2_part_2 = _mm_unpacklo_epi8(a, b);
-
-      a = _mm_unpacklo_epi8(row_2_part_1, row_2_part_2);
-      b = _mm_unpackhi_epi8(row_2_part_1, row_2_part_2);
-
-      c = _mm_unpacklo_epi8(a, b);
-      d = _mm_unpackhi_epi8(a, b);
-
-      a = _mm_unpacklo_epi8(c, d);
-      b = _mm_unpackhi_epi8(c, d);
-
-      __m128i row_2 = _mm_unpacklo_epi8(a, b);
-
-      // --------------------------------------------------------------------------------------------------------
-
-      // Now the actual calculations are performed
-      // Since sobel needs a 3 by 3 surrounding of a pixel, we shift the rows to the right, so that
-      // the correct values will be added
-      // for example:
-      // Y0 | Y1 | Y2
-      // Y3 | xx | Y4
-      // Y5 | Y6 | Y7
-      // To calculate the result xx we need to calculate gx = Y0 + Y3 * 2 + Y5 - Y2 - Y4 * 2 - Y7 (divide the whole equation by 4)
-      // To get all these values in the first 8 bit values of a register, the shifts are done
-      // i.e. row_0 is shifted 2 Bytes to the right, to get Y2 in the first 8-bit of the register
-      __m128i row_0_shifts_0 = row_0;
-      __m128i row_0_shifts_1 = _mm_srli_si128(row_0, 1);
-      __m128i row_0_shifts_2 = _mm_srli_si128(row_0, 2);
-      __m128i row_1_shifts_0 = row_1;
-      __m128i row_1_shifts_2 = _mm_srli_si128(row_1, 2);
-      __m128i row_2_shifts_0 = row_2;
-      __m128i row_2_shifts_1 = _mm_srli_si128(row_2, 1);
-      __m128i row_2_shifts_2 = _mm_srli_si128(row_2, 2);
-
-      // Divide by 2 (see above, Y3 and Y4 need to be divided by 2)
-      row_1_shifts_0 = _mm_srli_epi8(row_1_shifts_0, 1);
-      row_1_shifts_2 = _mm_srli_epi8(row_1_shifts_2, 1);
-
-      // Divide by 4
-      row_0_shifts_0 = _mm_srli_epi8(row_0_shifts_0, 2);
-      row_2_shifts_0 = _mm_srli_epi8(row_2_shifts_0, 2);
-      row_2_shifts_2 = _mm_srli_epi8(row_2_shifts_2, 2);
-      row_0_shifts_2 = _mm_srli_epi8(row_0_shifts_2, 2);
-
-
-      __m128i gx;
-      if (dir == Uni || dir == Horizontal)
-      {
-        // Calculate positiv and negative sum for X direction
-        __m128i gx_pos = _mm_adds_epu8(row_0_shifts_0, _mm_adds_epu8(row_2_shifts_0, row_1_shifts_0));
-        __m128i gx_neg = _mm_adds_epu8(row_0_shifts_2, _mm_adds_epu8(row_2_shifts_2, row_1_shifts_2));
+      std::fill(target.row(y), target.row(y) + width, static_cast<unsigned char>(0));
+    }
+  }
+  return getFinishedRows();
+}
 
-        // Calulate the absolute difference between the positive and negative sum in X direction
-        gx = _mm_subs_epu8(_mm_max_epu8(gx_pos, gx_neg), _mm_min_epu8(gx_pos, gx_neg));
-      }
+int SobelDortmund::Stream::getFinishedRows() const
+{
+  // Every row is finished once the row below has been pushed, the last row with itself
+  return pushedRows == height ? height : std::max(pushedRows - 1, 0);
+}
 
-      __m128i gy;
-      if (dir == Uni || dir == Vertical)
-      {
-        // Same for gy
-        // Multiply by 2 (see above)
-        row_0_shifts_1 = _mm_srli_epi8(row_0_shifts_1, 1);
-        row_2_shifts_1 = _mm_srli_epi8(row_2_shifts_1, 1);
+SobelDortmund::Incremental::Incremental(int width, int height, bool quarter, Direction dir, int tileSize, unsigned threshold)
+  : width(width), height(height), quarter(quarter), dir(dir), tileSize(std::max(tileSize, 1)), threshold(threshold),
+    tilesX((width + this->tileSize - 1) / this->tileSize), tilesY((height + this->tileSize - 1) / this->tileSize), valid(false),
+    result(width, height), previous(width * height), current(width * height + SobelBaseline::size), changes(tilesX * tilesY), dirtyTiles(tilesX * tilesY)
+{
+}
 
-        __m128i gy_pos = _mm_adds_epu8(row_0_shifts_0, _mm_adds_epu8(row_0_shifts_1, row_0_shifts_2));
-        __m128i gy_neg = _mm_adds_epu8(row_2_shifts_1, _mm_adds_epu8(row_2_shifts_0, row_2_shifts_2));
+void SobelDortmund::Incremental::reset()
+{
+  valid = false;
+}
 
-        gy = _mm_subs_epu8(_mm_max_epu8(gy_pos, gy_neg), _mm_min_epu8(gy_pos, gy_neg));
-      }
+int SobelDortmund::Incremental::update(const InputImage& image)
+{
+  SOBEL_INSTRUMENT("Incremental::update", width * height);
+  // Compare every tile with the previous frame
+  SobelKernelArgs args = makeKernelArgs(image, quarter, width, 0, 0, width - 1, height - 1, Uni);
+  SobelChangeArgs change = { previous.data(), current.data(), width, height, tileSize, tilesX, tilesY, changes.data() };
+  if (quarter)
+  {
+    sobelChangeQuarterKernel<SobelBaseline>(args, change);
+  }
+  else
+  {
+    sobelChangeFullKernel<SobelBaseline>(args, change);
+  }
 
-      __m128i result;
-      if (dir == Uni)
-      {
-        // The result should be calculated as sqrt( pow(gx,2) + pow(gy,2) )
-        // Since this is really slow and not easily done in 8-Bit because of massive overflow
-        // we gonna approximate this with the "Alpha max plus beta min"-algorithm
-        // with alpha = 1 and beta = 1/4 (since this is only a bitshift for the smaller value)
-        // see for example http://en.wikipedia.org/wiki/Alpha_max_plus_beta_min_algorithm
-        // or http://www.dspguru.com/dsp/tricks/magnitude-estimator
-        __m128i mins = _mm_min_epu8(gx, gy);
-        __m128i maxs = _mm_max_epu8(gx, gy);
-        mins = _mm_srli_epi8(mins, 2);
-        result = _mm_adds_epu8(mins, maxs);
-      }
-      else if (dir == Horizontal)
-      {
-        result = gx;
-      }
-      else
+  int dirty = 0;
+  for (size_t i = 0; i < changes.size(); ++i)
+  {
+    dirtyTiles[i] = !valid || changes[i] > threshold ? 1 : 0;
+    dirty += dirtyTiles[i];
+  }
+  const SobelBandFunction function = quarter ? runQuarterBand : runFullBand;
+  if (dirty == tilesX * tilesY)
+  {
+    // Calculated at once, so it is split into bands for the thread pool
+    calculateSobel(function, image, quarter, 0, 0, width - 1, height - 1, width, height, result.view(), dir, true, BorderZero);
+    std::copy(current.begin(), current.begin() + width * height, previous.begin());
+    valid = true;
+    return dirty;
+  }
+
+  for (int tileY = 0; tileY < tilesY; ++tileY)
+  {
+    const int startY = tileY * tileSize;
+    const int endY = std::min(startY + tileSize, height) - 1;
+    for (int tileX = 0; tileX < tilesX; ++tileX)
+    {
+      if (!dirtyTiles[tileY * tilesX + tileX])
       {
-        result = gy;
+        continue;
       }
 
-      // Store the result
-      if (returnFullArray)
+      // Neighbouring dirty tiles of a row are calculated together
+      const int startX = tileX * tileSize;
+      while (tileX + 1 < tilesX && dirtyTiles[tileY * tilesX + tileX + 1])
       {
-        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + j + i * width), result);
+        ++tileX;
       }
-      else
+      const int endX = std::min((tileX + 1) * tileSize, width) - 1;
+
+      // The tiles are the inner pixels of the rectangle grown by the halo, only at the border of the image they are not, which stays 0
+      calculateSobel(function, image, quarter, std::max(startX - 1, 0), std::max(startY - 1, 0), std::min(endX + 1, width - 1),
+                     std::min(endY + 1, height - 1), width, height, result.view(), dir, true, BorderUntouched);
+
+      // The clean tiles keep the Y values their result was calculated from, so slow changes below the threshold still add up
+      for (int y = startY; y <= endY; ++y)
       {
-        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + j + i * rectWidth), result);
+        std::copy(current.begin() + y * width + startX, current.begin() + y * width + endX + 1, previous.begin() + y * width + startX);
       }
-
-      j += 14;
     }
-    i++;
-    // Increase the row pointers
-    row_0_ptr += 8 * width;
-    row_1_ptr += 8 * width;
-    row_2_ptr += 8 * width;
   }
+  return dirty;
+}
+
+static int area(const SobelDortmund::Rectangle& r)
+{
+  return (r.endX - r.startX + 1) * (r.endY - r.startY + 1);
+}
 
+// The requested pixels of a batch, regions calculated twice or not at all because of the merging are not taken into account
+static int area(const std::vector<SobelDortmund::Rectangle>& rectangles)
+{
+  int size = 0;
+  for (const SobelDortmund::Rectangle& r : rectangles)
+  {
+    size += (std::abs(r.endX - r.startX) + 1) * (std::abs(r.endY - r.startY) + 1);
+  }
+  return size;
+}
 
-  if (returnFullArray)
+/**
+ * @brief Merges overlapping regions into their bounding box, as long as it is not larger than both regions together. The batch kernel extracts
+ * shared rows only once anyway, merging saves calculating the shared pixels twice. A larger bounding box would calculate more pixels than
+ * the overlap it saves.
+ */
+static void mergeRegions(std::vector<SobelDortmund::Rectangle>& regions)
+{
+  bool merged = true;
+  while (merged)
   {
-    for (int y = 0; y < height; ++y)
+    // A grown region might overlap regions it was already compared with, so repeat until nothing changes
+    merged = false;
+    for (size_t i = 0; i < regions.size(); ++i)
     {
-      for (int x = 0; x < width; ++x)
+      for (size_t j = i + 1; j < regions.size();)
       {
-        if (x <= startX || x >= endX - 1 || y <= startY || y >= endY - 1)
+        const SobelDortmund::Rectangle& a = regions[i];
+        const SobelDortmund::Rectangle& b = regions[j];
+        const SobelDortmund::Rectangle box = { std::min(a.startX, b.startX), std::min(a.startY, b.startY),
+                                               std::max(a.endX, b.endX), std::max(a.endY, b.endY) };
+        const bool overlap = a.startX <= b.endX && b.startX <= a.endX && a.startY <= b.endY && b.startY <= a.endY;
+        if (overlap && area(box) <= area(a) + area(b))
+        {
+          regions[i] = box;
+          regions.erase(regions.begin() + j);
+          merged = true;
+        }
+        else
         {
-          target[y * width + x] = 0;  // Set edges to 0
+          ++j;
         }
       }
     }
   }
-  else
+}
+
+/**
+ * @brief Calculates the merged regions of the rectangles in one sweep of the batch kernel into the arena of the result and returns a view per
+ * rectangle.
+ * @param function runBatchFullBand or runBatchQuarterBand.
+ * @param quarter Whether the coordinates are in the quarter image.
+ */
+static void calculateBatch(SobelBandFunction function, const SobelDortmund::InputImage& image, bool quarter,
+                           const std::vector<SobelDortmund::Rectangle>& rectangles, int width, int height, SobelDortmund::BatchResult& result,
+                           SobelDortmund::Direction dir)
+{
+  result.regions.clear();
+  for (const SobelDortmund::Rectangle& r : rectangles)
+  {
+    const SobelDortmund::Rectangle region = { std::min(r.startX, r.endX), std::min(r.startY, r.endY), std::max(r.startX, r.endX),
+                                              std::max(r.startY, r.endY) };
+    result.regions.push_back(region);
+  }
+  mergeRegions(result.regions);
+
+  int size = 0;
+  for (const SobelDortmund::Rectangle& region : result.regions)
   {
-    for (int i = 0; i < rectHeight; ++i)
+    size += area(region);
+  }
+  result.arena.resize(size);
+
+  // Every pixel of a region is calculated from the image with its rows and columns replicated, so it does not matter which region a pixel
+  // belongs to. All regions are calculated in one sweep over the rows, which extracts every row once.
+  static thread_local std::vector<SobelBatchRegion> batchRegions;
+  batchRegions.clear();
+  int offset = 0;
+  int yBegin = height;
+  int yEnd = 0;
+  for (const SobelDortmund::Rectangle& region : result.regions)
+  {
+    const SobelBatchRegion batchRegion = { region.startX, region.startY, region.endX, region.endY, result.arena.data() + offset };
+    batchRegions.push_back(batchRegion);
+    yBegin = std::min(yBegin, region.startY);
+    yEnd = std::max(yEnd, region.endY + 1);
+    offset += area(region);
+  }
+  std::sort(batchRegions.begin(), batchRegions.end(),
+            [](const SobelBatchRegion& a, const SobelBatchRegion& b) { return a.startX < b.startX; });
+
+  if (yBegin < yEnd)
+  {
+    SobelKernelArgs args = makeKernelArgs(image, quarter, width, 0, 0, width - 1, height - 1, dir);
+    args.yBegin = yBegin;
+    args.yEnd = yEnd;
+    const SobelBatchArgs batch = { batchRegions.data(), static_cast<int>(batchRegions.size()), width, height };
+    runBands(function, &batch, args);
+  }
+
+  result.views.clear();
+  for (const SobelDortmund::Rectangle& r : rectangles)
+  {
+    const int startX = std::min(r.startX, r.endX);
+    const int startY = std::min(r.startY, r.endY);
+    const int endX = std::max(r.startX, r.endX);
+    const int endY = std::max(r.startY, r.endY);
+
+    // Every rectangle is inside the region it was merged into, and any region containing it has the same results
+    offset = 0;
+    for (const SobelDortmund::Rectangle& region : result.regions)
     {
-      target[i * (rectWidth)] = 0;          // Set left edge to 0
-      target[(i + 1) * (rectWidth)-1] = 0;  // Set right edge to 0
+      if (region.startX <= startX && region.startY <= startY && endX <= region.endX && endY <= region.endY)
+      {
+        const int stride = region.endX - region.startX + 1;
+        unsigned char* origin = result.arena.data() + offset + (startY - region.startY) * stride + startX - region.startX;
+        result.views.push_back(stdVectorView2D<unsigned char>(origin, endX - startX + 1, endY - startY + 1, stride));
+        break;
+      }
+      offset += area(region);
     }
-    for (int j = 0; j < rectWidth; ++j)
+  }
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageFullBatch(const InputImage& YUVImage, const std::vector<Rectangle>& rectangles, int width, int height,
+                                                 BatchResult& result, Direction dir)
+{
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageFullBatch", area(rectangles));
+  calculateBatch(runBatchFullBand, YUVImage, false, rectangles, width, height, result, dir);
+}
+
+void SobelDortmund::sobelSSEAnyYUVImageQuarterBatch(const InputImage& YUVImage, const std::vector<Rectangle>& rectangles, int width, int height,
+                                                    BatchResult& result, Direction dir)
+{
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageQuarterBatch", area(rectangles));
+  calculateBatch(runBatchQuarterBand, YUVImage, true, rectangles, width, height, result, dir);
+}
+
+/**
+ * @brief Calculates the results along the scanlines into the arena of the result. The columns are calculated by the scanline kernel, which is
+ * split into bands like a rectangle, every row like a rectangle of the row and its neighbors.
+ * @param quarter Whether the coordinates are in the quarter image.
+ */
+static void calculateScanlines(const SobelDortmund::InputImage& image, bool quarter, const std::vector<int>& columns, const std::vector<int>& rows,
+                               int width, int height, SobelDortmund::ScanlineResult& result, SobelDortmund::Direction dir)
+{
+  const int columnCount = static_cast<int>(columns.size());
+  const int rowCount = static_cast<int>(rows.size());
+
+  // Only the inner pixels of the image are calculated, everything else stays 0
+  result.arena.assign(columnCount * height + rowCount * width, 0);
+  result.columns = stdVectorView2D<unsigned char>(result.arena.data(), height, columnCount);
+  result.rows = stdVectorView2D<unsigned char>(result.arena.data() + columnCount * height, width, rowCount);
+  if (width < 3 || height < 3)
+  {
+    return;
+  }
+
+  if (columnCount > 0)
+  {
+    const SobelScanlineArgs scanlines = { columns.data(), columnCount, width };
+    SobelKernelArgs args = makeKernelArgs(image, quarter, width, 0, 0, width - 1, height - 1, dir);
+    args.target = result.columns.data();
+    args.targetStride = height;
+    runBands(quarter ? runScanlineQuarterBand : runScanlineFullBand, &scanlines, args);
+  }
+
+  for (int i = 0; i < rowCount; ++i)
+  {
+    const int y = rows[i];
+    if (y >= 1 && y < height - 1)
     {
-      target[j] = 0;                                   // Set top edge to 0
-      target[(rectHeight - 1) * (rectWidth) + j] = 0;  // Set bottom edge to 0
+      SobelKernelArgs args = makeKernelArgs(image, quarter, width, 0, y - 1, width - 1, y + 1, dir);
+      args.target = result.rows.row(i);
+      args.targetStride = width;
+      args.originY = y;
+      if (quarter)
+      {
+        kernels().quarter(args);
+      }
+      else
+      {
+        kernels().full(args);
+      }
     }
   }
+}
 
-  return targetData;
+void SobelDortmund::sobelSSEAnyYUVImageFullScanlines(const InputImage& YUVImage, const std::vector<int>& columns, const std::vector<int>& rows,
+                                                     int width, int height, ScanlineResult& result, Direction dir)
+{
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageFullScanlines", columns.size() * height + rows.size() * width);
+  calculateScanlines(YUVImage, false, columns, rows, width, height, result, dir);
 }
 
+void SobelDortmund::sobelSSEAnyYUVImageQuarterScanlines(const InputImage& YUVImage, const std::vector<int>& columns, const std::vector<int>& rows,
+                                                        int width, int height, ScanlineResult& result, Direction dir)
+{
+  SOBEL_INSTRUMENT("sobelSSEAnyYUVImageQuarterScanlines", columns.size() * height + rows.size() * width);
+  calculateScanlines(YUVImage, true, columns, rows, width, height, result, dir);
+}
+
+SobelDortmund::CameraProfile SobelDortmund::cameraProfiles[2] =
+{
+  { 1280, 960, 640, 480, 2 * 1280, 1279, 959, 639, 479 },
+  { 640, 480, 320, 240, 2 * 640, 639, 479, 319, 239 }
+};
+
+void SobelDortmund::setCameraProfile(Camera camera, int width, int height)
+{
+  CameraProfile& profile = cameraProfiles[camera];
+  profile.width = width;
+  profile.height = height;
+  profile.quarterWidth = width / 2;
+  profile.quarterHeight = height / 2;
+  profile.rowStride = bytesPerColumn(YUYV, false) * width;
+  profile.lastX = width - 1;
+  profile.lastY = height - 1;
+  profile.quarterLastX = profile.quarterWidth - 1;
+  profile.quarterLastY = profile.quarterHeight - 1;
+}
+
+SobelDortmund::InstructionSet SobelDortmund::getInstructionSet()
+{
+  return activeInstructionSet();
+}
+
+bool SobelDortmund::setInstructionSet(InstructionSet instructionSet)
+{
+  if (instructionSet > detectInstructionSet())
+  {
+    return false;
+  }
+  activeInstructionSet() = instructionSet;
+  return true;
+}
+
+void SobelDortmund::setThreadCount(int threads)
+{
+  if (threads <= 0)
+  {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  if (threads == getThreadCount())
+  {
+    return;
+  }
+  threadPool.reset();
+  if (threads > 1)
+  {
+    threadPool.reset(new SobelThreadPool(threads));
+  }
+}
+
+int SobelDortmund::getThreadCount()
+{
+  return threadPool ? threadPool->getThreadCount() : 1;
+}
+
+bool SobelDortmund::isInstrumented()
+{
+#ifdef SOBEL_INSTRUMENTATION
+  return true;
+#else
+  return false;
+#endif
+}
+
+void SobelDortmund::getInstrumentation(std::vector<EntryPointStatistics>& snapshot)
+{
+  snapshot.clear();
+#ifdef SOBEL_INSTRUMENTATION
+  SobelCounterRegistry& registry = SobelCounterRegistry::instance();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const SobelCounters& counters : registry.counters)
+  {
+    if (counters.calls.load(std::memory_order_relaxed) > 0)
+    {
+      snapshot.emplace_back();
+      counters.read(snapshot.back());
+    }
+  }
+#endif
+}
+
+void SobelDortmund::resetInstrumentation()
+{
+#ifdef SOBEL_INSTRUMENTATION
+  SobelCounterRegistry& registry = SobelCounterRegistry::instance();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (SobelCounters& counters : registry.counters)
+  {
+    counters.reset();
+  }
+#endif
+}
 
 void SobelDortmund::switchStartEnd(int& startX, int& startY, int& endX, int& endY)
 {
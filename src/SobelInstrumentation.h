@@ -0,0 +1,204 @@
+/**
+ * @file src/SobelInstrumentation.h
+ *
+ * Declares the optional instrumentation of the public sobel functions. It is only compiled in with SOBEL_INSTRUMENTATION, otherwise
+ * SOBEL_INSTRUMENT expands to nothing that is evaluated and the snapshot of SobelDortmund::getInstrumentation is empty.
+ *
+ * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
+ */
+
+#pragma once
+
+#include "SobelDortmund.h"
+
+#ifdef SOBEL_INSTRUMENTATION
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief The counters of one entry point. They are updated with relaxed atomics, so the entry points may be called from several threads.
+ */
+struct SobelCounters
+{
+  // The durations are counted in a histogram of 8 buckets per octave of nanoseconds, durations below 8 ns have a bucket each.
+  // The last bucket also counts everything longer than about 2 minutes.
+  static const int bucketsPerOctave = 8;
+  static const int buckets = 36 * bucketsPerOctave;
+
+  const char* name;
+  std::atomic<unsigned long long> calls;
+  std::atomic<unsigned long long> pixels;
+  std::atomic<unsigned long long> nanoseconds;
+  std::atomic<unsigned long long> minNanoseconds;
+  std::atomic<unsigned long long> cycles;
+  std::atomic<unsigned> histogram[buckets];
+
+  explicit SobelCounters(const char* name) : name(name)
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    calls = 0;
+    pixels = 0;
+    nanoseconds = 0;
+    minNanoseconds = ~0ull;
+    cycles = 0;
+    for (int i = 0; i < buckets; ++i)
+    {
+      histogram[i] = 0;
+    }
+  }
+
+  static int bucket(unsigned long long duration)
+  {
+    if (duration < bucketsPerOctave)
+    {
+      return static_cast<int>(duration);
+    }
+    // The octave and the next 3 bits below its highest one
+    const int octave = 63 - __builtin_clzll(duration);
+    const int index = (octave - 2) * bucketsPerOctave + static_cast<int>((duration >> (octave - 3)) & (bucketsPerOctave - 1));
+    return index < buckets ? index : buckets - 1;
+  }
+
+  // The first duration not counted in the bucket anymore
+  static double bucketEnd(int index)
+  {
+    if (index < bucketsPerOctave)
+    {
+      return index + 1;
+    }
+    const int octave = index / bucketsPerOctave + 2;
+    return static_cast<double>((bucketsPerOctave + index % bucketsPerOctave + 1) * (1ull << (octave - 3)));
+  }
+
+  void add(unsigned long long callPixels, unsigned long long duration, unsigned long long callCycles)
+  {
+    calls.fetch_add(1, std::memory_order_relaxed);
+    pixels.fetch_add(callPixels, std::memory_order_relaxed);
+    nanoseconds.fetch_add(duration, std::memory_order_relaxed);
+    cycles.fetch_add(callCycles, std::memory_order_relaxed);
+    histogram[bucket(duration)].fetch_add(1, std::memory_order_relaxed);
+    unsigned long long minimum = minNanoseconds.load(std::memory_order_relaxed);
+    while (duration < minimum && !minNanoseconds.compare_exchange_weak(minimum, duration, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  /**
+   * @brief Fills the statistics from the counters. Calls running meanwhile might be counted partially.
+   */
+  void read(SobelDortmund::EntryPointStatistics& statistics) const
+  {
+    statistics.name = name;
+    statistics.calls = calls.load(std::memory_order_relaxed);
+    statistics.pixels = pixels.load(std::memory_order_relaxed);
+    statistics.minMicroseconds = minNanoseconds.load(std::memory_order_relaxed) / 1000.0;
+    statistics.meanMicroseconds = nanoseconds.load(std::memory_order_relaxed) / 1000.0 / statistics.calls;
+    statistics.cyclesPerPixel = statistics.pixels > 0 ? static_cast<double>(cycles.load(std::memory_order_relaxed)) / statistics.pixels : 0.0;
+
+    // The end of the bucket of the call at the 99th percentile, so it is at most one bucket (about 12%) too high
+    const unsigned long long rank = statistics.calls - statistics.calls / 100;
+    unsigned long long counted = 0;
+    statistics.p99Microseconds = 0.0;
+    for (int i = 0; i < buckets; ++i)
+    {
+      counted += histogram[i].load(std::memory_order_relaxed);
+      if (counted >= rank)
+      {
+        statistics.p99Microseconds = bucketEnd(i) / 1000.0;
+        break;
+      }
+    }
+  }
+};
+
+/**
+ * @brief All counters, in the order their entry points were called first. A deque never moves its elements, so the references stay valid.
+ * Registering only happens on the first call of each function, so the linear search by name does not matter.
+ */
+struct SobelCounterRegistry
+{
+  std::mutex mutex;
+  std::deque<SobelCounters> counters;
+
+  static SobelCounterRegistry& instance()
+  {
+    static SobelCounterRegistry registry;
+    return registry;
+  }
+
+  static SobelCounters& add(const char* name)
+  {
+    SobelCounterRegistry& registry = instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    // Overloads of one entry point share their counters
+    for (SobelCounters& counters : registry.counters)
+    {
+      if (std::strcmp(counters.name, name) == 0)
+      {
+        return counters;
+      }
+    }
+    registry.counters.emplace_back(name);
+    return registry.counters.back();
+  }
+};
+
+/**
+ * @brief Measures the scope it lives in and adds it to the counters when it ends.
+ */
+class SobelTimer
+{
+ public:
+  SobelTimer(SobelCounters& counters, long long pixels) :
+    counters(counters), pixels(pixels > 0 ? pixels : 0), startCycles(readCycles()), start(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~SobelTimer()
+  {
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    const unsigned long long endCycles = readCycles();
+    const long long duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    counters.add(pixels, static_cast<unsigned long long>(duration), endCycles - startCycles);
+  }
+
+ private:
+  // The time stamp counter, 0 where there is none
+  static unsigned long long readCycles()
+  {
+#if defined(__i386__) || defined(__x86_64__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  SobelCounters& counters;
+  unsigned long long pixels;
+  unsigned long long startCycles;
+  std::chrono::steady_clock::time_point start;
+};
+
+// Counts the rest of the enclosing function as one call of the entry point name, which calculates the given number of pixels.
+// The counters are registered on the first call.
+#define SOBEL_INSTRUMENT(name, pixels) \
+  static SobelCounters& sobelCounters = SobelCounterRegistry::add(name); \
+  const SobelTimer sobelTimer(sobelCounters, pixels)
+
+#else
+
+// The pixels are not evaluated, but still count as used
+#define SOBEL_INSTRUMENT(name, pixels) static_cast<void>(sizeof(pixels))
+
+#endif
@@ -0,0 +1,2632 @@
+/**
+ * @file src/SobelKernel.h
+ *
+ * Defines the sobel kernels as templates over the instruction set traits (SobelSSSE3, SobelAVX2, SobelAVX512BW).
+ * Every instruction set gets its own translation unit which is compiled with the matching compiler flags, the best
+ * one is then picked at runtime by SobelDortmund.
+ *
+ * A traits class V has to provide the register type V::Vec, the number of 8-bit values V::size per register and
+ * the static functions extractY, extractQuarterY, extractOddY, extractQuarterOddY, boxAverage, div2, div4, adds, subs, max, min, load, store, maskStore,
+ * as well as loadAligned and storeAligned, which may only be called with pointers aligned to V::size bytes.
+ * The kernels only used by the SSSE3 instruction set additionally need the 16-bit functions loadWide, add16, sub16, interleaveLo16 and interleaveHi16
+ * as well as extractUV, set1, cmpeq, bitAnd, bitOr, bitXor, andNot, movemask and sad.
+ *
+ * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
+ */
+
+#pragma once
+
+#include "SobelDortmund.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Arguments for one kernel call. All coordinates are in the coordinates of the (full or quarter) image.
+ * The kernel calculates the results for xBegin <= x < xEnd and yBegin <= y < yEnd, so the caller has to make
+ * sure that the 3x3 surrounding of every of these pixels is inside the image.
+ */
+struct SobelKernelArgs
+{
+  const unsigned char* image;  ///< The input image.
+  SobelDortmund::PixelFormat format;
+  SobelDortmund::QuarterSampling quarterSampling;
+  int rowStride;               ///< Bytes between two rows of the (full or quarter) image in the input image.
+  int xBegin;                  ///< First column to calculate.
+  int xEnd;                    ///< Column behind the last one to calculate.
+  int yBegin;                  ///< First row to calculate.
+  int yEnd;                    ///< Row behind the last one to calculate.
+  SobelDortmund::Direction dir;
+  unsigned char* target;       ///< Where the result of pixel (originX, originY) is stored.
+  int targetStride;            ///< Elements between two rows of the target.
+  int originX;
+  int originY;
+};
+
+// Maximum number of columns calculated per strip. The ring buffer of a strip holds the Y values of 3 rows of these columns,
+// which keeps it in the L1 cache. Wider rectangles are calculated in several strips.
+static const int sobelStripWidth = 2048;
+
+/**
+ * @brief The positive and negative sums of the sobel operator for V::size pixels, each already divided by 4.
+ * The gradients are gx = gx_neg - gx_pos (right minus left) and gy = gy_neg - gy_pos (bottom minus top).
+ */
+template<typename V> struct SobelSums
+{
+  typename V::Vec gx_pos, gx_neg, gy_pos, gy_neg;
+};
+
+/**
+ * @brief Calculates the sums of the sobel operator for V::size pixels from the Y values of three rows.
+ * Value i of the result belongs to the center of value i + 1 of row_1, so V::size + 2 values are read from each row.
+ * @param withGx, withGy Which of the sums are needed, the others are left uninitialized.
+ * @param alignedCenter Whether row_0 + 1 and row_2 + 1 are aligned to V::size bytes, so the center column is loaded with aligned loads.
+ */
+template<typename V, bool withGx, bool withGy, bool alignedCenter = false>
+inline SobelSums<V> sobelSums(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2)
+{
+  typedef typename V::Vec Vec;
+
+  // Since sobel needs a 3 by 3 surrounding of a pixel, each row is loaded at three offsets, so that
+  // the correct values will be added
+  // for example:
+  // Y0 | Y1 | Y2
+  // Y3 | xx | Y4
+  // Y5 | Y6 | Y7
+  // To calculate the result xx we need to calculate gx = Y0 + Y3 * 2 + Y5 - Y2 - Y4 * 2 - Y7 (divide the whole equation by 4)
+  // To get all these values in the first 8 bits of a register, the loads are shifted
+  // i.e. row_0 is loaded 2 Bytes further right, to get Y2 in the first 8-bit of the register
+  Vec row_0_shifts_0 = V::load(row_0);
+  Vec row_0_shifts_1 = alignedCenter ? V::loadAligned(row_0 + 1) : V::load(row_0 + 1);
+  Vec row_0_shifts_2 = V::load(row_0 + 2);
+  Vec row_1_shifts_0 = V::load(row_1);
+  Vec row_1_shifts_2 = V::load(row_1 + 2);
+  Vec row_2_shifts_0 = V::load(row_2);
+  Vec row_2_shifts_1 = alignedCenter ? V::loadAligned(row_2 + 1) : V::load(row_2 + 1);
+  Vec row_2_shifts_2 = V::load(row_2 + 2);
+
+  // Divide by 2 or 4 (see above, Y3 and Y4 need to be divided by 2)
+  row_1_shifts_0 = V::div2(row_1_shifts_0);
+  row_1_shifts_2 = V::div2(row_1_shifts_2);
+
+  // Divide by 4
+  row_0_shifts_0 = V::div4(row_0_shifts_0);
+  row_2_shifts_0 = V::div4(row_2_shifts_0);
+  row_2_shifts_2 = V::div4(row_2_shifts_2);
+  row_0_shifts_2 = V::div4(row_0_shifts_2);
+
+  SobelSums<V> sums;
+  if (withGx)
+  {
+    // Calculate positiv and negativ sum for X direction
+    sums.gx_pos = V::adds(row_0_shifts_0, V::adds(row_2_shifts_0, row_1_shifts_0));
+    sums.gx_neg = V::adds(row_0_shifts_2, V::adds(row_2_shifts_2, row_1_shifts_2));
+  }
+
+  if (withGy)
+  {
+    // Same for gy
+    // Multiply by 2 (see above)
+    row_0_shifts_1 = V::div2(row_0_shifts_1);
+    row_2_shifts_1 = V::div2(row_2_shifts_1);
+
+    sums.gy_pos = V::adds(row_0_shifts_0, V::adds(row_0_shifts_1, row_0_shifts_2));
+    sums.gy_neg = V::adds(row_2_shifts_1, V::adds(row_2_shifts_0, row_2_shifts_2));
+  }
+  return sums;
+}
+
+/**
+ * @brief Calculates the 8-bit sobel result from the sums. The direction is a template parameter, so all branches on it are resolved at
+ * compile time and the kernels have none left in their inner loop.
+ */
+template<typename V, SobelDortmund::Direction dir> inline typename V::Vec sobelMagnitude(const SobelSums<V>& sums)
+{
+  typedef typename V::Vec Vec;
+
+  Vec gx;
+  if (dir == SobelDortmund::Uni || dir == SobelDortmund::Horizontal)
+  {
+    // Calulate the absolute difference between the positive and negative sum in X direction
+    gx = V::subs(V::max(sums.gx_pos, sums.gx_neg), V::min(sums.gx_pos, sums.gx_neg));
+  }
+
+  Vec gy;
+  if (dir == SobelDortmund::Uni || dir == SobelDortmund::Vertical)
+  {
+    gy = V::subs(V::max(sums.gy_pos, sums.gy_neg), V::min(sums.gy_pos, sums.gy_neg));
+  }
+
+  if (dir == SobelDortmund::Uni)
+  {
+    // The result should be calculated as sqrt( pow(gx,2) + pow(gy,2) )
+    // Since this is really slow and not easily done in 8-Bit because of massive overflow
+    // we gonna approximate this with the "Alpha max plus beta min"-algorithm
+    // with alpha = 1 and beta = 1/4 (since this is only a bitshift for the smaller value)
+    // see for example http://en.wikipedia.org/wiki/Alpha_max_plus_beta_min_algorithm
+    // or http://www.dspguru.com/dsp/tricks/magnitude-estimator
+    Vec mins = V::min(gx, gy);
+    Vec maxs = V::max(gx, gy);
+    mins = V::div4(mins);
+    return V::adds(mins, maxs);
+  }
+  else if (dir == SobelDortmund::Horizontal)
+  {
+    return gx;
+  }
+  else
+  {
+    return gy;
+  }
+}
+
+/**
+ * @brief Calculates the sobel operator for V::size pixels from the Y values of three rows.
+ * Value i of the result belongs to the center of value i + 1 of row_1, so V::size + 2 values are read from each row.
+ */
+template<typename V, SobelDortmund::Direction dir, bool alignedCenter = false>
+inline typename V::Vec sobelStep(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2)
+{
+  return sobelMagnitude<V, dir>(sobelSums<V, dir != SobelDortmund::Vertical, dir != SobelDortmund::Horizontal, alignedCenter>(row_0, row_1, row_2));
+}
+
+/**
+ * @brief Same as above with the direction known only at runtime, for the few pixels calculated with the scalar traits.
+ */
+template<typename V> inline typename V::Vec sobelStep(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2,
+                                                      SobelDortmund::Direction dir)
+{
+  switch (dir)
+  {
+    case SobelDortmund::Horizontal:
+      return sobelStep<V, SobelDortmund::Horizontal>(row_0, row_1, row_2);
+    case SobelDortmund::Vertical:
+      return sobelStep<V, SobelDortmund::Vertical>(row_0, row_1, row_2);
+    default:
+      return sobelStep<V, SobelDortmund::Uni>(row_0, row_1, row_2);
+  }
+}
+
+/**
+ * @brief Quantizes the gradient direction into the 8 orientation bins described at SobelDortmund::sobelSSEAnyYUVImageOrientationFull.
+ * The needed signs of gx and gy are the comparisons of the positive and negative sums, which the magnitude drops.
+ */
+template<typename V> inline typename V::Vec sobelOrientation(const SobelSums<V>& sums)
+{
+  typedef typename V::Vec Vec;
+
+  // Absolute values and a 0xFF mask where gx or gy is negative, i.e. gx_pos > gx_neg
+  Vec absGx = V::subs(V::max(sums.gx_pos, sums.gx_neg), V::min(sums.gx_pos, sums.gx_neg));
+  Vec absGy = V::subs(V::max(sums.gy_pos, sums.gy_neg), V::min(sums.gy_pos, sums.gy_neg));
+  Vec gxNegative = V::andNot(V::cmpeq(V::max(sums.gx_pos, sums.gx_neg), sums.gx_neg), V::set1(-1));
+  Vec gyNegative = V::andNot(V::cmpeq(V::max(sums.gy_pos, sums.gy_neg), sums.gy_neg), V::set1(-1));
+
+  // The direction is horizontal if |gy| <= tan(22.5 deg) * |gx| and vertical if |gx| <= tan(22.5 deg) * |gy|.
+  // tan(22.5 deg) = 0.414 is approximated by 1/4 + 1/8 + 1/32, which again is only bitshifts.
+  Vec tanGx = V::adds(V::adds(V::div4(absGx), V::div4(V::div2(absGx))), V::div4(V::div4(V::div2(absGx))));
+  Vec tanGy = V::adds(V::adds(V::div4(absGy), V::div4(V::div2(absGy))), V::div4(V::div4(V::div2(absGy))));
+  Vec horizontal = V::cmpeq(V::max(tanGx, absGy), tanGx);
+  Vec vertical = V::cmpeq(V::max(tanGy, absGx), tanGy);
+
+  // Bin 0 or 4 if horizontal, 2 or 6 if vertical and 1, 3, 5 or 7 for the diagonals (counting clockwise from the right)
+  Vec four = V::set1(4);
+  Vec horizontalBin = V::bitAnd(gxNegative, four);
+  Vec verticalBin = V::bitOr(V::set1(2), V::bitAnd(gyNegative, four));
+  Vec diagonalBin = V::bitOr(V::bitOr(V::set1(1), V::bitAnd(V::bitXor(gxNegative, gyNegative), V::set1(2))), V::bitAnd(gyNegative, four));
+
+  // Horizontal wins over vertical, which only matters if both gradients are 0
+  Vec bin = V::bitOr(V::bitAnd(vertical, verticalBin), V::andNot(vertical, diagonalBin));
+  return V::bitOr(V::bitAnd(horizontal, horizontalBin), V::andNot(horizontal, bin));
+}
+
+/**
+ * @brief Stores a result, only the last store of a row, where less than V::size values are left, has to be masked.
+ * @param count Number of values left in this row.
+ */
+template<typename V> inline void storeResult(unsigned char* p, typename V::Vec result, int count)
+{
+  if (count >= V::size)
+  {
+    V::store(p, result);
+  }
+  else
+  {
+    V::maskStore(p, result, count);
+  }
+}
+
+/**
+ * @brief Extracts count Y values of a row of the input image.
+ * @param extract Extracts V::size Y values into one register, e.g. V::extractY.
+ * @param bytesPerValue Bytes between two of the extracted Y values.
+ * @param yOffset Byte of the first Y value, which is where the scalar fallback for short rows reads.
+ * @param row Pointer to the first byte of the first column, exactly bytesPerValue * count bytes are read.
+ * @param target Where the Y values are stored. Exactly count values are written: if count is not a multiple of V::size the last register
+ * overlaps the one before it, and if count is smaller than V::size the values are copied one by one.
+ */
+template<typename V, typename V::Vec (*extract)(const unsigned char*), int bytesPerValue, int yOffset>
+inline void extractRow(const unsigned char* row, int count, unsigned char* target)
+{
+  int i = 0;
+  for (; i + V::size <= count; i += V::size)
+  {
+    V::store(target + i, extract(row + bytesPerValue * i));
+  }
+  if (i < count)
+  {
+    if (count >= V::size)
+    {
+      // The last extraction ends exactly at the last column, so nothing right of it is read
+      V::store(target + count - V::size, extract(row + bytesPerValue * (count - V::size)));
+    }
+    else
+    {
+      for (; i < count; ++i)
+      {
+        target[i] = row[bytesPerValue * i + yOffset];
+      }
+    }
+  }
+}
+
+/**
+ * @brief How the Y values of the (full or quarter) image are read from an input image of the given pixel format. Provides bytesPerColumn,
+ * the bytes between two columns in the input image, and extractRow(row, rowStride, count, target), which extracts the Y values of a row
+ * starting at the first byte of a column. rowStride is the one of SobelKernelArgs, which is only needed by SobelBoxSampling.
+ */
+template<typename V, SobelDortmund::PixelFormat format, bool quarter> struct SobelSampling;
+
+template<typename V> struct SobelSampling<V, SobelDortmund::YUYV, false>
+{
+  static const int bytesPerColumn = 2;
+  static void extractRow(const unsigned char* row, int, int count, unsigned char* target) { ::extractRow<V, V::extractY, 2, 0>(row, count, target); }
+};
+
+template<typename V> struct SobelSampling<V, SobelDortmund::YUYV, true>
+{
+  static const int bytesPerColumn = 4;
+  static void extractRow(const unsigned char* row, int, int count, unsigned char* target) { ::extractRow<V, V::extractQuarterY, 4, 0>(row, count, target); }
+};
+
+template<typename V> struct SobelSampling<V, SobelDortmund::UYVY, false>
+{
+  static const int bytesPerColumn = 2;
+  static void extractRow(const unsigned char* row, int, int count, unsigned char* target) { ::extractRow<V, V::extractOddY, 2, 1>(row, count, target); }
+};
+
+template<typename V> struct SobelSampling<V, SobelDortmund::UYVY, true>
+{
+  static const int bytesPerColumn = 4;
+  static void extractRow(const unsigned char* row, int, int count, unsigned char* target) { ::extractRow<V, V::extractQuarterOddY, 4, 1>(row, count, target); }
+};
+
+// A Y8 row is already what the ring buffer holds, so it is just copied into it
+template<typename V> struct SobelSampling<V, SobelDortmund::Y8, false>
+{
+  static const int bytesPerColumn = 1;
+  static void extractRow(const unsigned char* row, int, int count, unsigned char* target) { ::extractRow<V, V::load, 1, 0>(row, count, target); }
+};
+
+// Every second value of a Y8 row is at the same place as the Y values of a YUYV row
+template<typename V> struct SobelSampling<V, SobelDortmund::Y8, true>
+{
+  static const int bytesPerColumn = 2;
+  static void extractRow(const unsigned char* row, int, int count, unsigned char* target) { ::extractRow<V, V::extractY, 2, 0>(row, count, target); }
+};
+
+/**
+ * @brief Extracts count Y values of the quarter image, each being the rounded average of a 2x2 block of the full image.
+ * @param extract Extracts V::size consecutive Y values of the full image into one register, e.g. V::extractY.
+ * @param bytesPerValue Bytes between two Y values of the full image.
+ * @param yOffset Byte of the first Y value, which is where the scalar fallback for short rows reads.
+ * @param row Pointer to the first byte of the first column in the upper of both rows, exactly 2 * bytesPerValue * count bytes are read
+ * from it and the row below.
+ * @param rowStride Bytes between two rows of the full image.
+ * @param target Where the Y values are stored. Exactly count values are written, like extractRow does.
+ */
+template<typename V, typename V::Vec (*extract)(const unsigned char*), int bytesPerValue, int yOffset>
+inline void extractBoxRow(const unsigned char* row, int rowStride, int count, unsigned char* target)
+{
+  const int half = bytesPerValue * V::size;
+  int i = 0;
+  for (; i + V::size <= count; i += V::size)
+  {
+    const unsigned char* p = row + 2 * bytesPerValue * i;
+    V::store(target + i, V::boxAverage(extract(p), extract(p + half), extract(p + rowStride), extract(p + rowStride + half)));
+  }
+  if (i < count)
+  {
+    if (count >= V::size)
+    {
+      // The last extraction ends exactly at the last column, so nothing right of it is read
+      const unsigned char* p = row + 2 * bytesPerValue * (count - V::size);
+      V::store(target + count - V::size, V::boxAverage(extract(p), extract(p + half), extract(p + rowStride), extract(p + rowStride + half)));
+    }
+    else
+    {
+      for (; i < count; ++i)
+      {
+        const unsigned char* p = row + 2 * bytesPerValue * i + yOffset;
+        target[i] = static_cast<unsigned char>((p[0] + p[bytesPerValue] + p[rowStride] + p[rowStride + bytesPerValue] + 2) >> 2);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Same as SobelSampling for the quarter image with SobelDortmund::BoxAverage, i.e. every Y value is the average of a 2x2 block.
+ */
+template<typename V, SobelDortmund::PixelFormat format> struct SobelBoxSampling;
+
+template<typename V> struct SobelBoxSampling<V, SobelDortmund::YUYV>
+{
+  static const int bytesPerColumn = 4;
+  static void extractRow(const unsigned char* row, int rowStride, int count, unsigned char* target)
+  {
+    extractBoxRow<V, V::extractY, 2, 0>(row, rowStride / 2, count, target);
+  }
+};
+
+template<typename V> struct SobelBoxSampling<V, SobelDortmund::UYVY>
+{
+  static const int bytesPerColumn = 4;
+  static void extractRow(const unsigned char* row, int rowStride, int count, unsigned char* target)
+  {
+    extractBoxRow<V, V::extractOddY, 2, 1>(row, rowStride / 2, count, target);
+  }
+};
+
+template<typename V> struct SobelBoxSampling<V, SobelDortmund::Y8>
+{
+  static const int bytesPerColumn = 2;
+  static void extractRow(const unsigned char* row, int rowStride, int count, unsigned char* target)
+  {
+    extractBoxRow<V, V::load, 1, 0>(row, rowStride / 2, count, target);
+  }
+};
+
+/**
+ * @brief Calls the row kernel of sobelRingKernel with the rows of the ring, for a radius of 1 as rowKernel(row_0, row_1, row_2, x, y, columns)
+ * and for larger ones as rowKernel(rows, x, y, columns).
+ */
+template<int radius> struct SobelRingRows
+{
+  template<typename RowKernel> static void call(const RowKernel& rowKernel, unsigned char* const* rows, int x, int y, int columns)
+  {
+    rowKernel(rows, x, y, columns);
+  }
+};
+
+template<> struct SobelRingRows<1>
+{
+  template<typename RowKernel> static void call(const RowKernel& rowKernel, unsigned char* const* rows, int x, int y, int columns)
+  {
+    rowKernel(rows[0], rows[1], rows[2], x, y, columns);
+  }
+};
+
+/**
+ * @brief Calculates the sobel operator using a ring buffer of 3 rows. The Y values of every row of the image are extracted only once
+ * into the ring, and the 3x3 surrounding is then loaded from there. So per output row only the row below is extracted.
+ * @param Sampling Reads the Y values of a row from the input image, see SobelSampling.
+ * @param rowKernel Called as rowKernel(row_0, row_1, row_2, x, y, columns) for every row of every strip, where row_i points to the Y value
+ * left of column x in the row above, the row itself and the row below. It calculates the results for the columns x to x + columns - 1 of row y.
+ * @param stripWidth Maximum number of columns per strip. All rows of a strip are calculated before the next strip.
+ * @param radius Rows and columns of the surrounding on each side of a pixel. With a radius larger than 1 the ring holds 2 * radius + 1 rows and
+ * the row kernel is called with all of them, see SobelRingRows. The rows point to the Y value radius columns left of column x.
+ */
+template<typename V, typename Sampling, int stripWidth, int radius, typename RowKernel>
+void sobelRingKernel(const SobelKernelArgs& args, const RowKernel& rowKernel)
+{
+  const int ringRows = 2 * radius + 1;
+
+  // The stencil of the last iteration reads up to V::size values behind the extracted ones and the rows are placed up to V::size - 1
+  // values behind the start of their cache line
+  const int ringRowSize = (stripWidth + 2 * radius + 2 * V::size + 63) / 64 * 64;
+  alignas(64) unsigned char ring[ringRows][ringRowSize];
+
+  // Without any inner row the rows above and below might not be part of the image
+  if (args.yBegin >= args.yEnd)
+  {
+    return;
+  }
+
+  for (int stripBegin = args.xBegin; stripBegin < args.xEnd; stripBegin += stripWidth)
+  {
+    const int columns = args.xEnd - stripBegin < stripWidth ? args.xEnd - stripBegin : stripWidth;
+
+    // The Y values of the columns and the surrounding, so radius more columns left and right
+    const int count = columns + 2 * radius;
+
+    // The first row of the surrounding of the first row to calculate
+    const unsigned char* source = args.image + (args.yBegin - radius) * args.rowStride + Sampling::bytesPerColumn * (stripBegin - radius);
+
+    // Every column of the rows is aligned like the same column of an 8-bit target, so a row kernel using aligned stores into the target can
+    // load the center column aligned as well. With a target stride that is a multiple of V::size this holds for every row.
+    const int offset = static_cast<int>((reinterpret_cast<std::uintptr_t>(args.target) + stripBegin - args.originX - radius) & (V::size - 1));
+    unsigned char* rows[ringRows];
+    for (int i = 0; i < ringRows; ++i)
+    {
+      rows[i] = ring[i] + offset;
+    }
+    for (int i = 0; i < ringRows - 1; ++i)
+    {
+      Sampling::extractRow(source + i * args.rowStride, args.rowStride, count, rows[i]);
+    }
+
+    for (int y = args.yBegin; y < args.yEnd; y++)
+    {
+      Sampling::extractRow(source + (ringRows - 1) * args.rowStride, args.rowStride, count, rows[ringRows - 1]);
+      source += args.rowStride;
+
+      SobelRingRows<radius>::call(rowKernel, rows, stripBegin, y, columns);
+
+      // The lower rows are the upper ones for the next row
+      unsigned char* top = rows[0];
+      for (int i = 0; i < ringRows - 1; ++i)
+      {
+        rows[i] = rows[i + 1];
+      }
+      rows[ringRows - 1] = top;
+    }
+  }
+}
+
+/**
+ * @brief Calls sobelRingKernel with the sampling of args.format and args.quarterSampling, so they are branched on once per call as well.
+ * @param quarter Whether the kernel calculates the quarter image.
+ */
+template<typename V, bool quarter, int stripWidth = sobelStripWidth, int radius = 1, typename RowKernel>
+void sobelFormatKernel(const SobelKernelArgs& args, const RowKernel& rowKernel)
+{
+  if (quarter && args.quarterSampling == SobelDortmund::BoxAverage)
+  {
+    switch (args.format)
+    {
+      case SobelDortmund::UYVY:
+        sobelRingKernel<V, SobelBoxSampling<V, SobelDortmund::UYVY>, stripWidth, radius>(args, rowKernel);
+        break;
+      case SobelDortmund::Y8:
+        sobelRingKernel<V, SobelBoxSampling<V, SobelDortmund::Y8>, stripWidth, radius>(args, rowKernel);
+        break;
+      default:
+        sobelRingKernel<V, SobelBoxSampling<V, SobelDortmund::YUYV>, stripWidth, radius>(args, rowKernel);
+        break;
+    }
+    return;
+  }
+
+  switch (args.format)
+  {
+    case SobelDortmund::UYVY:
+      sobelRingKernel<V, SobelSampling<V, SobelDortmund::UYVY, quarter>, stripWidth, radius>(args, rowKernel);
+      break;
+    case SobelDortmund::Y8:
+      sobelRingKernel<V, SobelSampling<V, SobelDortmund::Y8, quarter>, stripWidth, radius>(args, rowKernel);
+      break;
+    default:
+      sobelRingKernel<V, SobelSampling<V, SobelDortmund::YUYV, quarter>, stripWidth, radius>(args, rowKernel);
+      break;
+  }
+}
+
+/**
+ * @brief Calls sobelFormatKernel with the row kernel RowKernel<V, args.dir>, which is initialized with args and the given context.
+ * So the direction is branched on once per call and is a compile time constant in the inner loop.
+ */
+template<typename V, bool quarter, template<typename, SobelDortmund::Direction> class RowKernel, int radius = 1, typename... Context>
+void sobelDirectionKernel(const SobelKernelArgs& args, const Context&... context)
+{
+  switch (args.dir)
+  {
+    case SobelDortmund::Horizontal:
+    {
+      RowKernel<V, SobelDortmund::Horizontal> rowKernel = { args, context... };
+      sobelFormatKernel<V, quarter, sobelStripWidth, radius>(args, rowKernel);
+      break;
+    }
+    case SobelDortmund::Vertical:
+    {
+      RowKernel<V, SobelDortmund::Vertical> rowKernel = { args, context... };
+      sobelFormatKernel<V, quarter, sobelStripWidth, radius>(args, rowKernel);
+      break;
+    }
+    default:
+    {
+      RowKernel<V, SobelDortmund::Uni> rowKernel = { args, context... };
+      sobelFormatKernel<V, quarter, sobelStripWidth, radius>(args, rowKernel);
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Row kernel for sobelRingKernel calculating the 8-bit sobel result into args.target.
+ */
+template<typename V, SobelDortmund::Direction dir> struct SobelMagnitudeRow
+{
+  const SobelKernelArgs& args;
+
+  static bool isAligned(const unsigned char* p)
+  {
+    return (reinterpret_cast<std::uintptr_t>(p) & (V::size - 1)) == 0;
+  }
+
+  // Calculates the columns from i on with aligned stores, targetRow + i has to be aligned. Returns the first column not calculated.
+  template<bool alignedCenter>
+  int storeAligned(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2, unsigned char* targetRow, int i,
+                   int columns) const
+  {
+    for (; i + V::size <= columns; i += V::size)
+    {
+      V::storeAligned(targetRow + i, sobelStep<V, dir, alignedCenter>(row_0 + i, row_1 + i, row_2 + i));
+    }
+    return i;
+  }
+
+  void operator()(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2, int x, int y, int columns) const
+  {
+    unsigned char* targetRow = args.target + (y - args.originY) * args.targetStride + x - args.originX;
+
+    // Columns in front of the first aligned one of the target row
+    const int head = static_cast<int>(-reinterpret_cast<std::uintptr_t>(targetRow) & (V::size - 1));
+    int i = 0;
+    if (columns >= head + V::size)
+    {
+      if (head > 0)
+      {
+        // The unaligned first store overlaps the first aligned one, which stores the same values again
+        V::store(targetRow, sobelStep<V, dir>(row_0, row_1, row_2));
+        i = head;
+      }
+      if (isAligned(row_0 + 1 + i) && isAligned(row_2 + 1 + i))
+      {
+        i = storeAligned<true>(row_0, row_1, row_2, targetRow, i, columns);
+      }
+      else
+      {
+        i = storeAligned<false>(row_0, row_1, row_2, targetRow, i, columns);
+      }
+    }
+    for (; i + V::size <= columns; i += V::size)
+    {
+      V::store(targetRow + i, sobelStep<V, dir>(row_0 + i, row_1 + i, row_2 + i));
+    }
+    if (i < columns)
+    {
+      V::maskStore(targetRow + i, sobelStep<V, dir>(row_0 + i, row_1 + i, row_2 + i), columns - i);
+    }
+  }
+};
+
+/**
+ * @brief Calculates the sobel operator on a YUV422 image using every Y value.
+ */
+template<typename V> void sobelFullKernel(const SobelKernelArgs& args)
+{
+  sobelDirectionKernel<V, false, SobelMagnitudeRow>(args);
+}
+
+/**
+ * @brief Calculates the sobel operator on a YUV422 image using every second Y value and every second row.
+ */
+template<typename V> void sobelQuarterKernel(const SobelKernelArgs& args)
+{
+  sobelDirectionKernel<V, true, SobelMagnitudeRow>(args);
+}
+
+/**
+ * @brief Arguments of sobelStreamKernel, which handles one row pushed into a SobelDortmund::Stream.
+ */
+struct SobelStreamArgs
+{
+  const unsigned char* source;        ///< The pushed row of the input image.
+  SobelDortmund::PixelFormat format;
+  int width;                          ///< Width of the image.
+  SobelDortmund::Direction dir;
+  unsigned char* rows[3];             ///< Y values of the row above, the row itself and the pushed row below, which is extracted into rows[2].
+  unsigned char* target;              ///< Sobel result of the row itself, nullptr if the pushed row is only extracted.
+};
+
+/**
+ * @brief Extracts the Y values of a pushed row and calculates the sobel result of the row above it. All rows have to be at least
+ * width + V::size values, since the last stencil reads behind the row.
+ */
+template<typename V> void sobelStreamKernel(const SobelStreamArgs& args)
+{
+  switch (args.format)
+  {
+    case SobelDortmund::UYVY:
+      SobelSampling<V, SobelDortmund::UYVY, false>::extractRow(args.source, 0, args.width, args.rows[2]);
+      break;
+    case SobelDortmund::Y8:
+      SobelSampling<V, SobelDortmund::Y8, false>::extractRow(args.source, 0, args.width, args.rows[2]);
+      break;
+    default:
+      SobelSampling<V, SobelDortmund::YUYV, false>::extractRow(args.source, 0, args.width, args.rows[2]);
+      break;
+  }
+
+  if (!args.target || args.width < 3)
+  {
+    return;
+  }
+
+  // Only the inner columns are calculated, target row is the row at y = 0
+  SobelKernelArgs rowArgs = SobelKernelArgs();
+  rowArgs.target = args.target;
+  switch (args.dir)
+  {
+    case SobelDortmund::Horizontal:
+    {
+      const SobelMagnitudeRow<V, SobelDortmund::Horizontal> rowKernel = { rowArgs };
+      rowKernel(args.rows[0], args.rows[1], args.rows[2], 1, 0, args.width - 2);
+      break;
+    }
+    case SobelDortmund::Vertical:
+    {
+      const SobelMagnitudeRow<V, SobelDortmund::Vertical> rowKernel = { rowArgs };
+      rowKernel(args.rows[0], args.rows[1], args.rows[2], 1, 0, args.width - 2);
+      break;
+    }
+    default:
+    {
+      const SobelMagnitudeRow<V, SobelDortmund::Uni> rowKernel = { rowArgs };
+      rowKernel(args.rows[0], args.rows[1], args.rows[2], 1, 0, args.width - 2);
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Target of the orientation bins. Like SobelKernelArgs::target it points to the result of pixel (originX, originY) and uses the same origin.
+ */
+struct SobelOrientationArgs
+{
+  unsigned char* orientation;
+  int orientationStride;
+};
+
+/**
+ * @brief Row kernel for sobelRingKernel calculating the 8-bit sobel result into args.target and the orientation bins in the same pass.
+ */
+template<typename V, SobelDortmund::Direction dir> struct SobelOrientationRow
+{
+  const SobelKernelArgs& args;
+  const SobelOrientationArgs& orientation;
+
+  void operator()(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2, int x, int y, int columns) const
+  {
+    unsigned char* targetRow = args.target + (y - args.originY) * args.targetStride + x - args.originX;
+    unsigned char* orientationRow = orientation.orientation + (y - args.originY) * orientation.orientationStride + x - args.originX;
+    for (int i = 0; i < columns; i += V::size)
+    {
+      // The orientation always needs both gradients, even if the magnitude uses only one of them
+      SobelSums<V> sums = sobelSums<V, true, true>(row_0 + i, row_1 + i, row_2 + i);
+      storeResult<V>(targetRow + i, sobelMagnitude<V, dir>(sums), columns - i);
+      storeResult<V>(orientationRow + i, sobelOrientation<V>(sums), columns - i);
+    }
+  }
+};
+
+/**
+ * @brief Calculates the sobel operator and the orientation bins on a YUV422 image using every Y value.
+ */
+template<typename V> void sobelOrientationFullKernel(const SobelKernelArgs& args, const SobelOrientationArgs& orientation)
+{
+  sobelDirectionKernel<V, false, SobelOrientationRow>(args, orientation);
+}
+
+/**
+ * @brief Calculates the sobel operator and the orientation bins on a YUV422 image using every second Y value and every second row.
+ */
+template<typename V> void sobelOrientationQuarterKernel(const SobelKernelArgs& args, const SobelOrientationArgs& orientation)
+{
+  sobelDirectionKernel<V, true, SobelOrientationRow>(args, orientation);
+}
+
+/**
+ * @brief Arguments of the edge point kernels.
+ */
+struct SobelEdgePointArgs
+{
+  std::vector<SobelDortmund::EdgePoint>* points;  ///< Where the points are appended.
+  unsigned char threshold;
+  bool withGradients;
+};
+
+/**
+ * @brief Row kernel for sobelRingKernel collecting the pixels whose sobel result is at least the threshold. If args.target is not a null pointer,
+ * the dense result is stored as well.
+ */
+template<typename V, SobelDortmund::Direction dir> struct SobelEdgePointRow
+{
+  const SobelKernelArgs& args;
+  const SobelEdgePointArgs& edgePoints;
+
+  void operator()(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2, int x, int y, int columns) const
+  {
+    unsigned char* targetRow = args.target ? args.target + (y - args.originY) * args.targetStride + x - args.originX : nullptr;
+    const typename V::Vec threshold = V::set1(static_cast<char>(edgePoints.threshold));
+    for (int i = 0; i < columns; i += V::size)
+    {
+      typename V::Vec result = sobelStep<V, dir>(row_0 + i, row_1 + i, row_2 + i);
+      if (targetRow)
+      {
+        storeResult<V>(targetRow + i, result, columns - i);
+      }
+
+      // One bit per value at least the threshold. Most registers do not contain any point, so they are skipped right away.
+      unsigned mask = V::movemask(V::cmpeq(V::max(result, threshold), result));
+      if (columns - i < V::size)
+      {
+        mask &= (1u << (columns - i)) - 1;
+      }
+      if (!mask)
+      {
+        continue;
+      }
+      alignas(64) unsigned char magnitudes[V::size];
+      V::store(magnitudes, result);
+      while (mask)
+      {
+        const int j = i + __builtin_ctz(mask);
+        mask &= mask - 1;
+
+        SobelDortmund::EdgePoint point;
+        point.x = static_cast<short>(x + j);
+        point.y = static_cast<short>(y);
+        point.magnitude = magnitudes[j - i];
+        point.gx = 0;
+        point.gy = 0;
+        if (edgePoints.withGradients)
+        {
+          // The exact gradients are only needed for the few points, so they are calculated from the Y values in the ring buffer
+          point.gx = static_cast<short>(row_0[j + 2] + 2 * row_1[j + 2] + row_2[j + 2] - row_0[j] - 2 * row_1[j] - row_2[j]);
+          point.gy = static_cast<short>(row_2[j] + 2 * row_2[j + 1] + row_2[j + 2] - row_0[j] - 2 * row_0[j + 1] - row_0[j + 2]);
+        }
+        edgePoints.points->push_back(point);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Collects the edge points of a YUV422 image using every Y value.
+ */
+template<typename V> void sobelEdgePointFullKernel(const SobelKernelArgs& args, const SobelEdgePointArgs& edgePoints)
+{
+  sobelDirectionKernel<V, false, SobelEdgePointRow>(args, edgePoints);
+}
+
+/**
+ * @brief Collects the edge points of a YUV422 image using every second Y value and every second row.
+ */
+template<typename V> void sobelEdgePointQuarterKernel(const SobelKernelArgs& args, const SobelEdgePointArgs& edgePoints)
+{
+  sobelDirectionKernel<V, true, SobelEdgePointRow>(args, edgePoints);
+}
+
+// Maximum number of columns of a strip for the canny edge detector. Non-maximum suppression and hysteresis need the whole row, so the strips
+// are much wider than for the other kernels. Wider rectangles are split into independent strips, whose outer columns are no edges.
+static const int sobelCannyStripWidth = 4096;
+
+/**
+ * @brief State of the canny edge detector, which is streamed row by row behind the sobel kernel. It keeps the magnitude and orientation of the
+ * last three rows only, so the magnitude image is never stored. Every row of args.target is written once by the non-maximum suppression
+ * and the hysteresis then only follows the edges into rows that are already done.
+ *
+ * The non-maximum suppression labels every pixel as 0, weak (1) or strong (255) edge. Weak edges become strong if they are connected to a strong
+ * one, i.e. the pixels left of and above a weak edge are checked when it is reached, and from every new strong edge all connected weak edges
+ * of the done rows are followed. So when the last row is done, all connected weak edges are 255 and only the unconnected ones have to be cleared.
+ * A weak edge can still be connected through any later row, so they cannot be cleared earlier. Instead the weak edges left unconnected when
+ * their row is done are collected and only those are cleared at the end, so there is no second pass over the edges.
+ */
+template<typename V> struct SobelCannyState
+{
+  SobelCannyState(const SobelKernelArgs& args, unsigned char low, unsigned char high) :
+    args(args), low(low), high(high), stripBegin(0), columns(0)
+  {
+  }
+
+  const SobelKernelArgs& args;
+  unsigned char low;   ///< Minimum magnitude of a weak edge.
+  unsigned char high;  ///< Minimum magnitude of a strong edge.
+
+  int stripBegin;  ///< First column of the current strip, columns is 0 before the first strip.
+  int columns;
+
+  // Magnitude and orientation of the last three rows, row y is stored at (y - args.yBegin + 1) % 3. Each row starts with the value left of the
+  // strip, which like the one right of it and the rows above and below the rectangle is 0, since these are the border.
+  alignas(64) unsigned char magnitude[3][sobelCannyStripWidth + 2 + V::size];
+  alignas(64) unsigned char orientation[3][sobelCannyStripWidth + 2 + V::size];
+
+  unsigned char* edgeRow(int y) const
+  {
+    return args.target + (y - args.originY) * args.targetStride + stripBegin - args.originX;
+  }
+
+  int slot(int y) const
+  {
+    return (y - args.yBegin + 1) % 3;
+  }
+
+  /**
+   * @brief Finishes the current strip, if there is one, and starts the next one.
+   */
+  void beginStrip(int x, int stripColumns)
+  {
+    finishStrip();
+    stripBegin = x;
+    columns = stripColumns;
+    std::memset(magnitude[slot(args.yBegin - 1)], 0, sizeof(magnitude[0]));
+  }
+
+  /**
+   * @brief Calculates the magnitude and orientation of row y, then the edges of the row above are known.
+   */
+  void addRow(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2, int y)
+  {
+    unsigned char* magnitudeRow = magnitude[slot(y)];
+    unsigned char* orientationRow = orientation[slot(y)];
+    magnitudeRow[0] = 0;
+    for (int i = 0; i < columns; i += V::size)
+    {
+      SobelSums<V> sums = sobelSums<V, true, true>(row_0 + i, row_1 + i, row_2 + i);
+      V::store(magnitudeRow + 1 + i, sobelMagnitude<V, SobelDortmund::Uni>(sums));
+      V::store(orientationRow + 1 + i, sobelOrientation<V>(sums));
+    }
+    magnitudeRow[columns + 1] = 0;
+
+    if (y > args.yBegin)
+    {
+      suppress(y - 1);
+    }
+  }
+
+  /**
+   * @brief Calculates the edges of the last row and clears all weak edges, which are not connected to a strong one.
+   */
+  void finishStrip()
+  {
+    if (columns == 0)
+    {
+      return;
+    }
+    std::memset(magnitude[slot(args.yEnd)], 0, sizeof(magnitude[0]));
+    suppress(args.yEnd - 1);
+
+    std::vector<unsigned char*>& weak = weakEdges();
+    for (unsigned char* edge : weak)
+    {
+      if (*edge == 1)
+      {
+        *edge = 0;
+      }
+    }
+    weak.clear();
+    columns = 0;
+  }
+
+  /**
+   * @brief The weak edges which were not connected when their row was done. Kept between calls, so no memory is allocated once it is large enough.
+   */
+  static std::vector<unsigned char*>& weakEdges()
+  {
+    static thread_local std::vector<unsigned char*> weak;
+    return weak;
+  }
+
+  /**
+   * @brief Labels the pixels of row y, which are maxima along their gradient direction, as weak or strong edges and follows them.
+   */
+  void suppress(int y)
+  {
+    typedef typename V::Vec Vec;
+
+    const unsigned char* above = magnitude[slot(y - 1)];
+    const unsigned char* center = magnitude[slot(y)];
+    const unsigned char* below = magnitude[slot(y + 1)];
+    const unsigned char* bins = orientation[slot(y)] + 1;
+    unsigned char* edges = edgeRow(y);
+
+    for (int i = 0; i < columns; i += V::size)
+    {
+      // The neighbours along the gradient direction, the bins modulo 4 are 0: left/right, 1: top left/bottom right, 2: top/bottom and
+      // 3: top right/bottom left
+      Vec bin = V::bitAnd(V::load(bins + i), V::set1(3));
+      Vec isHorizontal = V::cmpeq(bin, V::set1(0));
+      Vec isFalling = V::cmpeq(bin, V::set1(1));
+      Vec isVertical = V::cmpeq(bin, V::set1(2));
+      Vec isRising = V::cmpeq(bin, V::set1(3));
+      Vec first = V::bitOr(V::bitOr(V::bitAnd(isHorizontal, V::load(center + i)), V::bitAnd(isFalling, V::load(above + i))),
+                           V::bitOr(V::bitAnd(isVertical, V::load(above + i + 1)), V::bitAnd(isRising, V::load(above + i + 2))));
+      Vec second = V::bitOr(V::bitOr(V::bitAnd(isHorizontal, V::load(center + i + 2)), V::bitAnd(isFalling, V::load(below + i + 2))),
+                            V::bitOr(V::bitAnd(isVertical, V::load(below + i + 1)), V::bitAnd(isRising, V::load(below + i))));
+
+      // Keep the pixel if it is greater than the first and at least as great as the second neighbour, so a ridge of two equal values
+      // stays one pixel wide
+      Vec value = V::load(center + i + 1);
+      Vec isMaximum = V::andNot(V::cmpeq(V::max(first, value), first), V::cmpeq(V::max(value, second), value));
+      Vec isStrong = V::cmpeq(V::max(value, V::set1(static_cast<char>(high))), value);
+      Vec isWeak = V::cmpeq(V::max(value, V::set1(static_cast<char>(low))), value);
+      storeResult<V>(edges + i, V::bitAnd(isMaximum, V::bitOr(isStrong, V::bitAnd(isWeak, V::set1(1)))), columns - i);
+    }
+
+    follow(y);
+  }
+
+  /**
+   * @brief Hysteresis for row y, the rows above are already done.
+   */
+  void follow(int y)
+  {
+    std::vector<unsigned char*>& weak = weakEdges();
+    unsigned char* edges = edgeRow(y);
+    const unsigned char* edgesAbove = y > args.yBegin ? edgeRow(y - 1) : nullptr;
+    for (int i = 0; i < columns; ++i)
+    {
+      if (edges[i] == 0)
+      {
+        continue;
+      }
+      if (edges[i] == 1)
+      {
+        bool connected = (i > 0 && edges[i - 1] == 255);
+        if (edgesAbove)
+        {
+          connected = connected || edgesAbove[i] == 255 || (i > 0 && edgesAbove[i - 1] == 255) || (i + 1 < columns && edgesAbove[i + 1] == 255);
+        }
+        if (!connected)
+        {
+          weak.push_back(edges + i);
+          continue;
+        }
+        edges[i] = 255;
+      }
+      fill(i, y, y);
+    }
+  }
+
+  /**
+   * @brief Marks all weak edges connected to the strong edge (x, y) as strong, only rows up to lastRow are done.
+   */
+  void fill(int x, int y, int lastRow)
+  {
+    // Kept between calls, so no memory is allocated once it is large enough
+    static thread_local std::vector<int> stack;
+    stack.clear();
+    stack.push_back(x);
+    stack.push_back(y);
+    while (!stack.empty())
+    {
+      const int cy = stack.back();
+      stack.pop_back();
+      const int cx = stack.back();
+      stack.pop_back();
+      for (int ny = cy - 1; ny <= cy + 1; ++ny)
+      {
+        if (ny < args.yBegin || ny > lastRow)
+        {
+          continue;
+        }
+        unsigned char* row = edgeRow(ny);
+        for (int nx = cx - 1; nx <= cx + 1; ++nx)
+        {
+          if (nx >= 0 && nx < columns && row[nx] == 1)
+          {
+            row[nx] = 255;
+            stack.push_back(nx);
+            stack.push_back(ny);
+          }
+        }
+      }
+    }
+  }
+};
+
+/**
+ * @brief Row kernel for sobelRingKernel feeding the canny edge detector.
+ */
+template<typename V> struct SobelCannyRow
+{
+  SobelCannyState<V>& state;
+
+  void operator()(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2, int x, int y, int columns) const
+  {
+    if (y == state.args.yBegin)
+    {
+      state.beginStrip(x, columns);
+    }
+    state.addRow(row_0, row_1, row_2, y);
+  }
+};
+
+/**
+ * @brief Calculates the canny edges of a YUV422 image using every Y value into args.target. Every edge is 255, everything else 0.
+ * The rows depend on each other, so this has to run on one thread.
+ */
+template<typename V> void sobelCannyFullKernel(const SobelKernelArgs& args, unsigned char low, unsigned char high)
+{
+  SobelCannyState<V> state(args, low, high);
+  SobelCannyRow<V> rowKernel = { state };
+  sobelFormatKernel<V, false, sobelCannyStripWidth>(args, rowKernel);
+  state.finishStrip();
+}
+
+/**
+ * @brief Calculates the canny edges of a YUV422 image using every second Y value and every second row.
+ * @see sobelCannyFullKernel
+ */
+template<typename V> void sobelCannyQuarterKernel(const SobelKernelArgs& args, unsigned char low, unsigned char high)
+{
+  SobelCannyState<V> state(args, low, high);
+  SobelCannyRow<V> rowKernel = { state };
+  sobelFormatKernel<V, true, sobelCannyStripWidth>(args, rowKernel);
+  state.finishStrip();
+}
+
+/**
+ * @brief Targets of the signed 16-bit gradients. Like SobelKernelArgs::target they point to the result of pixel (originX, originY).
+ * If gy is a null pointer, gx and gy are stored interleaved into gx, i.e. gx at 2 * x and gy at 2 * x + 1.
+ */
+struct SobelGradientArgs
+{
+  short* gx;
+  int gxStride;
+  short* gy;
+  int gyStride;
+  int originX;
+  int originY;
+};
+
+/**
+ * @brief Calculates the exact signed sobel gradients for V::size / 2 pixels from the Y values of three rows, using 16-bit values.
+ * gx is positive if the image gets brighter to the right, gy if it gets brighter downwards. Both are between -1020 and 1020.
+ */
+template<typename V> inline void sobelGradientStep(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2,
+                                                   typename V::Vec& gx, typename V::Vec& gy)
+{
+  typedef typename V::Vec Vec;
+
+  // Same surrounding as in sobelStep, but widened to 16 bit, so there is no need to divide or saturate
+  Vec row_0_shifts_0 = V::loadWide(row_0);
+  Vec row_0_shifts_1 = V::loadWide(row_0 + 1);
+  Vec row_0_shifts_2 = V::loadWide(row_0 + 2);
+  Vec row_1_shifts_0 = V::loadWide(row_1);
+  Vec row_1_shifts_2 = V::loadWide(row_1 + 2);
+  Vec row_2_shifts_0 = V::loadWide(row_2);
+  Vec row_2_shifts_1 = V::loadWide(row_2 + 1);
+  Vec row_2_shifts_2 = V::loadWide(row_2 + 2);
+
+  Vec gx_pos = V::add16(V::add16(row_0_shifts_2, row_2_shifts_2), V::add16(row_1_shifts_2, row_1_shifts_2));
+  Vec gx_neg = V::add16(V::add16(row_0_shifts_0, row_2_shifts_0), V::add16(row_1_shifts_0, row_1_shifts_0));
+  gx = V::sub16(gx_pos, gx_neg);
+
+  Vec gy_pos = V::add16(V::add16(row_2_shifts_0, row_2_shifts_2), V::add16(row_2_shifts_1, row_2_shifts_1));
+  Vec gy_neg = V::add16(V::add16(row_0_shifts_0, row_0_shifts_2), V::add16(row_0_shifts_1, row_0_shifts_1));
+  gy = V::sub16(gy_pos, gy_neg);
+}
+
+/**
+ * @brief Stores V::size / 2 16-bit values, only the last store of a row is masked.
+ * @param count Number of values left in this row.
+ */
+template<typename V> inline void storeResult16(short* p, typename V::Vec result, int count)
+{
+  if (count >= V::size / 2)
+  {
+    V::store(reinterpret_cast<unsigned char*>(p), result);
+  }
+  else
+  {
+    V::maskStore(reinterpret_cast<unsigned char*>(p), result, 2 * count);
+  }
+}
+
+/**
+ * @brief Row kernel for sobelRingKernel calculating the signed 16-bit gradients.
+ */
+template<typename V> struct SobelGradientRow
+{
+  const SobelGradientArgs& gradients;
+
+  void operator()(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2, int x, int y, int columns) const
+  {
+    const int step = V::size / 2;
+    short* gxRow = gradients.gx + (y - gradients.originY) * gradients.gxStride;
+    if (gradients.gy)
+    {
+      gxRow += x - gradients.originX;
+      short* gyRow = gradients.gy + (y - gradients.originY) * gradients.gyStride + x - gradients.originX;
+      for (int i = 0; i < columns; i += step)
+      {
+        typename V::Vec gx, gy;
+        sobelGradientStep<V>(row_0 + i, row_1 + i, row_2 + i, gx, gy);
+        storeResult16<V>(gxRow + i, gx, columns - i);
+        storeResult16<V>(gyRow + i, gy, columns - i);
+      }
+    }
+    else
+    {
+      gxRow += 2 * (x - gradients.originX);
+      for (int i = 0; i < columns; i += step)
+      {
+        typename V::Vec gx, gy;
+        sobelGradientStep<V>(row_0 + i, row_1 + i, row_2 + i, gx, gy);
+
+        // The first register gets the pairs of the first half of the pixels, the second one of the other half
+        storeResult16<V>(gxRow + 2 * i, V::interleaveLo16(gx, gy), 2 * (columns - i));
+        if (columns - i > step / 2)
+        {
+          storeResult16<V>(gxRow + 2 * i + step, V::interleaveHi16(gx, gy), 2 * (columns - i) - step);
+        }
+      }
+    }
+  }
+};
+
+/**
+ * @brief Calculates the signed 16-bit gradients on a YUV422 image using every Y value. The target of args is not used.
+ */
+template<typename V> void sobelGradientFullKernel(const SobelKernelArgs& args, const SobelGradientArgs& gradients)
+{
+  SobelGradientRow<V> rowKernel = { gradients };
+  sobelFormatKernel<V, false>(args, rowKernel);
+}
+
+/**
+ * @brief Calculates the signed 16-bit gradients on a YUV422 image using every second Y value and every second row. The target of args is not used.
+ */
+template<typename V> void sobelGradientQuarterKernel(const SobelKernelArgs& args, const SobelGradientArgs& gradients)
+{
+  SobelGradientRow<V> rowKernel = { gradients };
+  sobelFormatKernel<V, true>(args, rowKernel);
+}
+
+// Number of levels calculated by sobelPyramidKernel, each being half the width and height of the one above
+static const int sobelPyramidLevels = 3;
+
+/**
+ * @brief State of sobelPyramidKernel. Every level keeps its last 4 rows of Y values, so the two rows averaged into the next level are always
+ * next to each other in memory and the 3 rows of the sobel operator are still there.
+ */
+template<typename V, SobelDortmund::Direction dir> struct SobelPyramid
+{
+  const SobelKernelArgs* levels;  ///< The kernel arguments of every level, covering the whole level.
+  unsigned char* rows;            ///< 4 rows of rowSize values per level.
+  int rowSize;
+
+  unsigned char* row(int level, int y) const
+  {
+    return rows + (4 * level + (y & 3)) * rowSize;
+  }
+
+  /**
+   * @brief Called after row y of a level has been stored. Calculates the sobel result of the row above and, once two rows are there,
+   * the next row of the level below.
+   */
+  void addRow(int level, int y) const
+  {
+    const SobelKernelArgs& args = levels[level];
+    if (y >= 2 && args.xBegin < args.xEnd && y - 1 < args.yEnd)
+    {
+      SobelMagnitudeRow<V, dir> rowKernel = { args };
+      rowKernel(row(level, y - 2), row(level, y - 1), row(level, y), args.xBegin, y - 1, args.xEnd - args.xBegin);
+    }
+
+    if ((y & 1) && level + 1 < sobelPyramidLevels)
+    {
+      const SobelKernelArgs& next = levels[level + 1];
+      if (y / 2 <= next.yEnd)
+      {
+        // Rows y - 1 and y are next to each other, since y - 1 is even
+        extractBoxRow<V, V::load, 1, 0>(row(level, y - 1), rowSize, next.xEnd + 1, row(level + 1, y / 2));
+        addRow(level + 1, y / 2);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Calculates the sobel operator on all levels of the pyramid in a single pass over the input image. The first level is the quarter image
+ * using the 2x2 box average, every further level the 2x2 box average of the level above.
+ * @param levels The kernel arguments of every level. Each covers the inner pixels of its whole level, so xEnd + 1 and yEnd + 1 are its size.
+ * @param rows 4 * sobelPyramidLevels rows of rowSize values, rowSize being at least the width of the first level plus V::size.
+ */
+template<typename V, typename Sampling, SobelDortmund::Direction dir>
+void sobelPyramidKernel(const SobelKernelArgs* levels, unsigned char* rows, int rowSize)
+{
+  const SobelPyramid<V, dir> pyramid = { levels, rows, rowSize };
+  const SobelKernelArgs& args = levels[0];
+  for (int y = 0; y <= args.yEnd; ++y)
+  {
+    Sampling::extractRow(args.image + y * args.rowStride, args.rowStride, args.xEnd + 1, pyramid.row(0, y));
+    pyramid.addRow(0, y);
+  }
+}
+
+/**
+ * @brief Calls sobelPyramidKernel with the direction as compile time constant.
+ */
+template<typename V, typename Sampling> void sobelPyramidKernel(const SobelKernelArgs* levels, unsigned char* rows, int rowSize)
+{
+  switch (levels[0].dir)
+  {
+    case SobelDortmund::Horizontal:
+      sobelPyramidKernel<V, Sampling, SobelDortmund::Horizontal>(levels, rows, rowSize);
+      break;
+    case SobelDortmund::Vertical:
+      sobelPyramidKernel<V, Sampling, SobelDortmund::Vertical>(levels, rows, rowSize);
+      break;
+    default:
+      sobelPyramidKernel<V, Sampling, SobelDortmund::Uni>(levels, rows, rowSize);
+      break;
+  }
+}
+
+/**
+ * @brief Calls sobelPyramidKernel with the box sampling of the pixel format of the first level.
+ */
+template<typename V> void sobelPyramidKernel(const SobelKernelArgs* levels, unsigned char* rows, int rowSize)
+{
+  switch (levels[0].format)
+  {
+    case SobelDortmund::UYVY:
+      sobelPyramidKernel<V, SobelBoxSampling<V, SobelDortmund::UYVY>>(levels, rows, rowSize);
+      break;
+    case SobelDortmund::Y8:
+      sobelPyramidKernel<V, SobelBoxSampling<V, SobelDortmund::Y8>>(levels, rows, rowSize);
+      break;
+    default:
+      sobelPyramidKernel<V, SobelBoxSampling<V, SobelDortmund::YUYV>>(levels, rows, rowSize);
+      break;
+  }
+}
+
+/**
+ * @brief Returns the sum of the absolute differences of count values of a and b.
+ */
+template<typename V> inline unsigned sumOfAbsoluteDifferences(const unsigned char* a, const unsigned char* b, int count)
+{
+  unsigned sum = 0;
+  int i = 0;
+  for (; i + V::size <= count; i += V::size)
+  {
+    sum += V::sad(V::load(a + i), V::load(b + i));
+  }
+  for (; i < count; ++i)
+  {
+    const int difference = a[i] - b[i];
+    sum += difference < 0 ? -difference : difference;
+  }
+  return sum;
+}
+
+/**
+ * @brief Arguments of sobelChangeFullKernel. The image is split into tiles of tileSize by tileSize pixels, the last ones may be smaller.
+ */
+struct SobelChangeArgs
+{
+  const unsigned char* previous;  ///< The Y values of the previous frame, width by height without padding.
+  unsigned char* current;         ///< Receives the Y values of this frame, same size as previous plus V::size values.
+  int width;                      ///< Of the (full or quarter) image.
+  int height;
+  int tileSize;
+  int tilesX;
+  int tilesY;
+  unsigned* changes;              ///< Per tile, the sum of the absolute differences of its Y values and the one pixel wide halo around it.
+};
+
+/**
+ * @brief Extracts the Y values of the image into change.current and compares every tile with its halo with change.previous. Each row is
+ * compared right after its extraction, while it is still in the cache. Only the image, its row stride and format of args are used.
+ * @param Sampling Reads the Y values of a row from the input image, see SobelSampling.
+ */
+template<typename V, typename Sampling> void sobelChangeKernel(const SobelKernelArgs& args, const SobelChangeArgs& change)
+{
+  const int width = change.width;
+  const int tileSize = change.tileSize;
+  std::memset(change.changes, 0, change.tilesX * change.tilesY * sizeof(unsigned));
+  for (int y = 0; y < change.height; ++y)
+  {
+    unsigned char* current = change.current + y * width;
+    const unsigned char* previous = change.previous + y * width;
+    Sampling::extractRow(args.image + y * args.rowStride, args.rowStride, width, current);
+
+    // The halo of a tile reaches into the last row of the tiles above and the first row of those below, so a row can count for two rows of tiles
+    const int tileY = y / tileSize;
+    const bool countAbove = y % tileSize == 0 && tileY > 0;
+    const bool countBelow = (y + 1) % tileSize == 0 && tileY + 1 < change.tilesY;
+    unsigned* changes = change.changes + tileY * change.tilesX;
+    for (int tileX = 0; tileX < change.tilesX; ++tileX)
+    {
+      const int begin = tileX * tileSize;
+      const int end = begin + tileSize < width ? begin + tileSize : width;
+      unsigned sum = sumOfAbsoluteDifferences<V>(current + begin, previous + begin, end - begin);
+
+      // The halo columns left and right of the tile
+      if (begin > 0)
+      {
+        sum += sumOfAbsoluteDifferences<V>(current + begin - 1, previous + begin - 1, 1);
+      }
+      if (end < width)
+      {
+        sum += sumOfAbsoluteDifferences<V>(current + end, previous + end, 1);
+      }
+
+      changes[tileX] += sum;
+      if (countAbove)
+      {
+        changes[tileX - change.tilesX] += sum;
+      }
+      if (countBelow)
+      {
+        changes[tileX + change.tilesX] += sum;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Calls sobelChangeKernel with the sampling of args.format and args.quarterSampling.
+ * @param quarter Whether the tiles are in the quarter image.
+ */
+template<typename V, bool quarter> void sobelChangeFormatKernel(const SobelKernelArgs& args, const SobelChangeArgs& change)
+{
+  if (quarter && args.quarterSampling == SobelDortmund::BoxAverage)
+  {
+    switch (args.format)
+    {
+      case SobelDortmund::UYVY:
+        sobelChangeKernel<V, SobelBoxSampling<V, SobelDortmund::UYVY>>(args, change);
+        break;
+      case SobelDortmund::Y8:
+        sobelChangeKernel<V, SobelBoxSampling<V, SobelDortmund::Y8>>(args, change);
+        break;
+      default:
+        sobelChangeKernel<V, SobelBoxSampling<V, SobelDortmund::YUYV>>(args, change);
+        break;
+    }
+    return;
+  }
+
+  switch (args.format)
+  {
+    case SobelDortmund::UYVY:
+      sobelChangeKernel<V, SobelSampling<V, SobelDortmund::UYVY, quarter>>(args, change);
+      break;
+    case SobelDortmund::Y8:
+      sobelChangeKernel<V, SobelSampling<V, SobelDortmund::Y8, quarter>>(args, change);
+      break;
+    default:
+      sobelChangeKernel<V, SobelSampling<V, SobelDortmund::YUYV, quarter>>(args, change);
+      break;
+  }
+}
+
+/**
+ * @brief Compares the tiles of a YUV422 image using every Y value with the previous frame, see sobelChangeKernel.
+ */
+template<typename V> void sobelChangeFullKernel(const SobelKernelArgs& args, const SobelChangeArgs& change)
+{
+  sobelChangeFormatKernel<V, false>(args, change);
+}
+
+/**
+ * @brief Same as sobelChangeFullKernel using every second Y value and every second row.
+ */
+template<typename V> void sobelChangeQuarterKernel(const SobelKernelArgs& args, const SobelChangeArgs& change)
+{
+  sobelChangeFormatKernel<V, true>(args, change);
+}
+
+/**
+ * @brief Extracts count U and V values of a YUV422 row, one of each per pixel pair.
+ * @param uOffset Byte of the U value in a pair, see SobelSSSE3::extractUV.
+ * @param row Pointer to the first byte of the first pair, exactly 4 * count bytes are read.
+ * @param u Where the U values are stored.
+ * @param v Where the V values are stored.
+ */
+template<typename V, int uOffset> inline void extractChromaRow(const unsigned char* row, int count, unsigned char* u, unsigned char* v)
+{
+  typename V::Vec uValues, vValues;
+  int i = 0;
+  for (; i + V::size <= count; i += V::size)
+  {
+    V::template extractUV<uOffset>(row + 4 * i, uValues, vValues);
+    V::store(u + i, uValues);
+    V::store(v + i, vValues);
+  }
+  if (i < count)
+  {
+    if (count >= V::size)
+    {
+      // The last extraction ends exactly at the last pair, so nothing right of it is read
+      V::template extractUV<uOffset>(row + 4 * (count - V::size), uValues, vValues);
+      V::store(u + count - V::size, uValues);
+      V::store(v + count - V::size, vValues);
+    }
+    else
+    {
+      for (; i < count; ++i)
+      {
+        u[i] = row[4 * i + uOffset];
+        v[i] = row[4 * i + uOffset + 2];
+      }
+    }
+  }
+}
+
+/**
+ * @brief How the U and V values are read from an input image of the given pixel format. Provides extractRow(row, count, u, v), which extracts
+ * the values of count pixel pairs starting at the first byte of a pair.
+ */
+template<typename V, SobelDortmund::PixelFormat format> struct SobelChromaSampling;
+
+template<typename V> struct SobelChromaSampling<V, SobelDortmund::YUYV>
+{
+  static void extractRow(const unsigned char* row, int count, unsigned char* u, unsigned char* v) { extractChromaRow<V, 1>(row, count, u, v); }
+};
+
+template<typename V> struct SobelChromaSampling<V, SobelDortmund::UYVY>
+{
+  static void extractRow(const unsigned char* row, int count, unsigned char* u, unsigned char* v) { extractChromaRow<V, 0>(row, count, u, v); }
+};
+
+// A Y8 image has no color, so its chroma is constant and has no gradients
+template<typename V> struct SobelChromaSampling<V, SobelDortmund::Y8>
+{
+  static void extractRow(const unsigned char*, int count, unsigned char* u, unsigned char* v)
+  {
+    std::memset(u, 128, count);
+    std::memset(v, 128, count);
+  }
+};
+
+/**
+ * @brief Targets and columns of the chroma results. The chroma columns are the pixel pairs of the YUV422 image, i.e. chroma column c holds
+ * the U and V values of the pixels 2 * c and 2 * c + 1 of the full image, which is pixel c of the quarter image. The rows are those of
+ * SobelKernelArgs. If v is a null pointer, the combined color edge strength is stored into u.
+ */
+struct SobelChromaArgs
+{
+  unsigned char* u;  ///< Where the result of chroma column originX in row SobelKernelArgs::originY is stored.
+  int uStride;
+  unsigned char* v;
+  int vStride;
+  int xBegin;        ///< First chroma column to calculate.
+  int xEnd;          ///< Chroma column behind the last one to calculate.
+  int originX;
+};
+
+/**
+ * @brief Moves the rows of a ring buffer of 3 rows up, so the two lower rows are the upper ones for the next row.
+ */
+inline void rotateRing(unsigned char* rows[3])
+{
+  unsigned char* top = rows[0];
+  rows[0] = rows[1];
+  rows[1] = rows[2];
+  rows[2] = top;
+}
+
+/**
+ * @brief Calculates the sobel operator on the Y values like sobelRingKernel with SobelMagnitudeRow and in the same pass on the U and V values.
+ * Every row of the image is read once, its U and V values are kept in ring buffers of their own.
+ * @param Sampling Reads the Y values of a row from the input image, see SobelSampling.
+ * @param ChromaSampling Reads the U and V values of a row, see SobelChromaSampling. They are always taken from the row itself, also with
+ * SobelDortmund::BoxAverage.
+ * @param pairColumns Columns of the (full or quarter) image per pixel pair, i.e. 2 for the full and 1 for the quarter image.
+ */
+template<typename V, typename Sampling, typename ChromaSampling, int pairColumns, SobelDortmund::Direction dir>
+void sobelChromaRingKernel(const SobelKernelArgs& args, const SobelChromaArgs& chroma)
+{
+  // The stencil of the last iteration reads up to V::size values behind the extracted ones
+  alignas(64) unsigned char ring[3][sobelStripWidth + 2 + V::size];
+  alignas(64) unsigned char uRing[3][sobelStripWidth + 2 + V::size];
+  alignas(64) unsigned char vRing[3][sobelStripWidth + 2 + V::size];
+
+  // Without any inner row the rows above and below might not be part of the image
+  if (args.yBegin >= args.yEnd)
+  {
+    return;
+  }
+
+  const SobelMagnitudeRow<V, dir> magnitudeRow = { args };
+  for (int stripBegin = args.xBegin; stripBegin < args.xEnd; stripBegin += sobelStripWidth)
+  {
+    const int columns = args.xEnd - stripBegin < sobelStripWidth ? args.xEnd - stripBegin : sobelStripWidth;
+    const int count = columns + 2;
+
+    // The chroma columns of the pairs starting in the strip, the first and the last strip take those left and right of the rectangle as well
+    const int stripEnd = stripBegin + columns;
+    const int firstPair = (stripBegin + pairColumns - 1) / pairColumns;
+    const int endPair = (stripEnd + pairColumns - 1) / pairColumns;
+    const int chromaBegin = stripBegin == args.xBegin || firstPair < chroma.xBegin ? chroma.xBegin : firstPair;
+    const int chromaEnd = stripEnd == args.xEnd || endPair > chroma.xEnd ? chroma.xEnd : endPair;
+    const int chromaColumns = chromaEnd - chromaBegin;
+
+    // The row above the first one to calculate
+    const unsigned char* source = args.image + (args.yBegin - 1) * args.rowStride;
+    const int yOffset = Sampling::bytesPerColumn * (stripBegin - 1);
+    const int chromaOffset = 4 * (chromaBegin - 1);
+    unsigned char* rows[3] = { ring[0], ring[1], ring[2] };
+    unsigned char* uRows[3] = { uRing[0], uRing[1], uRing[2] };
+    unsigned char* vRows[3] = { vRing[0], vRing[1], vRing[2] };
+    for (int i = 0; i < 2; ++i)
+    {
+      Sampling::extractRow(source + i * args.rowStride + yOffset, args.rowStride, count, rows[i]);
+      if (chromaColumns > 0)
+      {
+        ChromaSampling::extractRow(source + i * args.rowStride + chromaOffset, chromaColumns + 2, uRows[i], vRows[i]);
+      }
+    }
+
+    for (int y = args.yBegin; y < args.yEnd; y++)
+    {
+      source += args.rowStride;
+      Sampling::extractRow(source + args.rowStride + yOffset, args.rowStride, count, rows[2]);
+      magnitudeRow(rows[0], rows[1], rows[2], stripBegin, y, columns);
+
+      if (chromaColumns > 0)
+      {
+        ChromaSampling::extractRow(source + args.rowStride + chromaOffset, chromaColumns + 2, uRows[2], vRows[2]);
+        unsigned char* uRow = chroma.u + (y - args.originY) * chroma.uStride + chromaBegin - chroma.originX;
+        if (chroma.v)
+        {
+          unsigned char* vRow = chroma.v + (y - args.originY) * chroma.vStride + chromaBegin - chroma.originX;
+          for (int i = 0; i < chromaColumns; i += V::size)
+          {
+            storeResult<V>(uRow + i, sobelStep<V, dir>(uRows[0] + i, uRows[1] + i, uRows[2] + i), chromaColumns - i);
+            storeResult<V>(vRow + i, sobelStep<V, dir>(vRows[0] + i, vRows[1] + i, vRows[2] + i), chromaColumns - i);
+          }
+        }
+        else
+        {
+          for (int i = 0; i < chromaColumns; i += V::size)
+          {
+            storeResult<V>(uRow + i, V::adds(sobelStep<V, dir>(uRows[0] + i, uRows[1] + i, uRows[2] + i),
+                                             sobelStep<V, dir>(vRows[0] + i, vRows[1] + i, vRows[2] + i)), chromaColumns - i);
+          }
+        }
+      }
+
+      rotateRing(rows);
+      rotateRing(uRows);
+      rotateRing(vRows);
+    }
+  }
+}
+
+/**
+ * @brief Calls sobelChromaRingKernel with the direction as compile time constant.
+ */
+template<typename V, typename Sampling, typename ChromaSampling, int pairColumns>
+void sobelChromaDirectionKernel(const SobelKernelArgs& args, const SobelChromaArgs& chroma)
+{
+  switch (args.dir)
+  {
+    case SobelDortmund::Horizontal:
+      sobelChromaRingKernel<V, Sampling, ChromaSampling, pairColumns, SobelDortmund::Horizontal>(args, chroma);
+      break;
+    case SobelDortmund::Vertical:
+      sobelChromaRingKernel<V, Sampling, ChromaSampling, pairColumns, SobelDortmund::Vertical>(args, chroma);
+      break;
+    default:
+      sobelChromaRingKernel<V, Sampling, ChromaSampling, pairColumns, SobelDortmund::Uni>(args, chroma);
+      break;
+  }
+}
+
+/**
+ * @brief Calls sobelChromaDirectionKernel with the sampling of args.format and args.quarterSampling.
+ * @param quarter Whether the kernel calculates the quarter image.
+ */
+template<typename V, bool quarter> void sobelChromaFormatKernel(const SobelKernelArgs& args, const SobelChromaArgs& chroma)
+{
+  const int pairColumns = quarter ? 1 : 2;
+  if (quarter && args.quarterSampling == SobelDortmund::BoxAverage)
+  {
+    switch (args.format)
+    {
+      case SobelDortmund::UYVY:
+        sobelChromaDirectionKernel<V, SobelBoxSampling<V, SobelDortmund::UYVY>, SobelChromaSampling<V, SobelDortmund::UYVY>, pairColumns>(args, chroma);
+        break;
+      case SobelDortmund::Y8:
+        sobelChromaDirectionKernel<V, SobelBoxSampling<V, SobelDortmund::Y8>, SobelChromaSampling<V, SobelDortmund::Y8>, pairColumns>(args, chroma);
+        break;
+      default:
+        sobelChromaDirectionKernel<V, SobelBoxSampling<V, SobelDortmund::YUYV>, SobelChromaSampling<V, SobelDortmund::YUYV>, pairColumns>(args, chroma);
+        break;
+    }
+    return;
+  }
+
+  switch (args.format)
+  {
+    case SobelDortmund::UYVY:
+      sobelChromaDirectionKernel<V, SobelSampling<V, SobelDortmund::UYVY, quarter>, SobelChromaSampling<V, SobelDortmund::UYVY>, pairColumns>(args, chroma);
+      break;
+    case SobelDortmund::Y8:
+      sobelChromaDirectionKernel<V, SobelSampling<V, SobelDortmund::Y8, quarter>, SobelChromaSampling<V, SobelDortmund::Y8>, pairColumns>(args, chroma);
+      break;
+    default:
+      sobelChromaDirectionKernel<V, SobelSampling<V, SobelDortmund::YUYV, quarter>, SobelChromaSampling<V, SobelDortmund::YUYV>, pairColumns>(args, chroma);
+      break;
+  }
+}
+
+/**
+ * @brief Calculates the sobel operator on a YUV422 image using every Y value and in the same pass on its U and V values.
+ */
+template<typename V> void sobelChromaFullKernel(const SobelKernelArgs& args, const SobelChromaArgs& chroma)
+{
+  sobelChromaFormatKernel<V, false>(args, chroma);
+}
+
+/**
+ * @brief Calculates the sobel operator on a YUV422 image using every second Y value and every second row and in the same pass on the U and
+ * V values of these rows.
+ */
+template<typename V> void sobelChromaQuarterKernel(const SobelKernelArgs& args, const SobelChromaArgs& chroma)
+{
+  sobelChromaFormatKernel<V, true>(args, chroma);
+}
+
+/**
+ * @brief Arguments of the statistics kernels. The tiles start at (originX, originY) of SobelKernelArgs. While the kernels run, count of a tile
+ * holds the number of pixels with a result below the threshold and histogram[i] for i > 0 the number of pixels below i * 256 / histogramBins,
+ * which sobelStatisticsBins turns into the final values.
+ */
+struct SobelStatisticsArgs
+{
+  SobelDortmund::TileStatistics* tiles;  ///< tilesX times the rows of tiles, accumulated into.
+  int tilesX;
+  int tileSize;
+  unsigned char threshold;
+};
+
+/**
+ * @brief Turns the counts of pixels below the threshold and below the upper limit of each bin into the count and the histogram.
+ */
+inline void sobelStatisticsBins(SobelDortmund::TileStatistics& tile)
+{
+  const int last = SobelDortmund::histogramBins - 1;
+  const unsigned belowLast = tile.histogram[last];
+  tile.count = tile.pixels - tile.count;
+
+  // Each bin gets the pixels below its upper limit, but not below its lower one. The counts of the upper limits are one index higher.
+  for (int i = 0; i < last; ++i)
+  {
+    tile.histogram[i] = tile.histogram[i + 1] - (i > 0 ? tile.histogram[i] : 0);
+  }
+  tile.histogram[last] = tile.pixels - belowLast;
+}
+
+/**
+ * @brief Row kernel for sobelRingKernel calculating the 8-bit sobel result into args.target and accumulating the statistics of the tiles.
+ * The results are counted per segment of a row within one tile. Every register adds 1 to 8-bit counters for each limit a result is below,
+ * which are summed up with sad at the end of the segment. The rest of a segment, which does not fill a register, is counted from the target.
+ */
+template<typename V, SobelDortmund::Direction dir> struct SobelStatisticsRow
+{
+  const SobelKernelArgs& args;
+  const SobelStatisticsArgs& statistics;
+
+  // Registers per sum of the 8-bit counters, so they can not saturate
+  static const int maxRegisters = 255;
+
+  void operator()(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2, int x, int y, int columns) const
+  {
+    typedef typename V::Vec Vec;
+    const int binSize = 256 / SobelDortmund::histogramBins;
+    const Vec zero = V::set1(0);
+    const Vec one = V::set1(1);
+
+    // limits[0] is the threshold, limits[i] the upper limit of bin i - 1. min(subs(limit, result), 1) is 1 for every result below the limit.
+    Vec limits[SobelDortmund::histogramBins];
+    limits[0] = V::set1(static_cast<char>(statistics.threshold));
+    for (int i = 1; i < SobelDortmund::histogramBins; ++i)
+    {
+      limits[i] = V::set1(static_cast<char>(i * binSize));
+    }
+
+    unsigned char* targetRow = args.target + (y - args.originY) * args.targetStride + x - args.originX;
+    SobelDortmund::TileStatistics* tiles = statistics.tiles + (y - args.originY) / statistics.tileSize * statistics.tilesX;
+    int tileX = (x - args.originX) / statistics.tileSize;
+    for (int begin = 0; begin < columns; ++tileX)
+    {
+      // The segment of the row in this tile
+      const int tileEnd = (tileX + 1) * statistics.tileSize + args.originX - x;
+      const int end = tileEnd < columns ? tileEnd : columns;
+      SobelDortmund::TileStatistics& tile = tiles[tileX];
+
+      // Accumulated locally, as the stores into the target could alias the tile
+      Vec maximum = zero;
+      unsigned sum = 0;
+      unsigned counts[SobelDortmund::histogramBins] = {};
+      int i = begin;
+      while (i + V::size <= end)
+      {
+        Vec below[SobelDortmund::histogramBins];
+        for (int limit = 0; limit < SobelDortmund::histogramBins; ++limit)
+        {
+          below[limit] = zero;
+        }
+        for (int registers = 0; registers < maxRegisters && i + V::size <= end; ++registers, i += V::size)
+        {
+          const Vec result = sobelStep<V, dir>(row_0 + i, row_1 + i, row_2 + i);
+          V::store(targetRow + i, result);
+          sum += V::sad(result, zero);
+          maximum = V::max(maximum, result);
+          for (int limit = 0; limit < SobelDortmund::histogramBins; ++limit)
+          {
+            below[limit] = V::adds(below[limit], V::min(V::subs(limits[limit], result), one));
+          }
+        }
+        for (int limit = 0; limit < SobelDortmund::histogramBins; ++limit)
+        {
+          counts[limit] += V::sad(below[limit], zero);
+        }
+      }
+      tile.sum += sum;
+      tile.count += counts[0];
+      for (int limit = 1; limit < SobelDortmund::histogramBins; ++limit)
+      {
+        tile.histogram[limit] += counts[limit];
+      }
+
+      // The maximum of the segment is only searched if it is larger than that of the tile, which gets rare after a few rows
+      const Vec tileMaximum = V::set1(static_cast<char>(tile.max));
+      if (V::movemask(V::cmpeq(V::max(maximum, tileMaximum), tileMaximum)) != V::movemask(V::cmpeq(zero, zero)))
+      {
+        alignas(64) unsigned char values[V::size];
+        V::store(values, maximum);
+        for (int j = 0; j < V::size; ++j)
+        {
+          tile.max = values[j] > tile.max ? values[j] : tile.max;
+        }
+      }
+
+      if (i < end)
+      {
+        V::maskStore(targetRow + i, sobelStep<V, dir>(row_0 + i, row_1 + i, row_2 + i), end - i);
+        for (; i < end; ++i)
+        {
+          const unsigned char result = targetRow[i];
+          tile.sum += result;
+          tile.count += result < statistics.threshold ? 1 : 0;
+          for (int limit = result / binSize + 1; limit < SobelDortmund::histogramBins; ++limit)
+          {
+            ++tile.histogram[limit];
+          }
+          tile.max = result > tile.max ? result : tile.max;
+        }
+      }
+      tile.pixels += end - begin;
+      begin = end;
+    }
+  }
+};
+
+/**
+ * @brief Calculates the sobel operator on a YUV422 image using every Y value and the statistics of its tiles.
+ */
+template<typename V> void sobelStatisticsFullKernel(const SobelKernelArgs& args, const SobelStatisticsArgs& statistics)
+{
+  sobelDirectionKernel<V, false, SobelStatisticsRow>(args, statistics);
+}
+
+/**
+ * @brief Calculates the sobel operator on a YUV422 image using every second Y value and every second row and the statistics of its tiles.
+ */
+template<typename V> void sobelStatisticsQuarterKernel(const SobelKernelArgs& args, const SobelStatisticsArgs& statistics)
+{
+  sobelDirectionKernel<V, true, SobelStatisticsRow>(args, statistics);
+}
+
+/**
+ * @brief Weights a corner of the Scharr operator with 3 / 16, split into 1/8 + 1/16 so it is only shifts.
+ */
+template<typename V> inline typename V::Vec scharrCorner(typename V::Vec a)
+{
+  typename V::Vec quarter = V::div4(a);
+  return V::adds(V::div2(quarter), V::div4(quarter));
+}
+
+/**
+ * @brief Weights a center of the Scharr operator with 10 / 16, split into 1/2 + 1/8.
+ */
+template<typename V> inline typename V::Vec scharrCenter(typename V::Vec a)
+{
+  typename V::Vec half = V::div2(a);
+  return V::adds(half, V::div4(half));
+}
+
+/**
+ * @brief Calculates the sums of the Scharr operator for V::size pixels from the Y values of three rows, the same way as sobelSums but with
+ * the weights 3, 10, 3 divided by 16. Each sum is at most 250, so the saturating adds never saturate.
+ */
+template<typename V, bool withGx, bool withGy>
+inline SobelSums<V> scharrSums(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2)
+{
+  typedef typename V::Vec Vec;
+
+  // The corners are part of both gradients, so they are only weighted once
+  Vec row_0_shifts_0 = scharrCorner<V>(V::load(row_0));
+  Vec row_0_shifts_2 = scharrCorner<V>(V::load(row_0 + 2));
+  Vec row_2_shifts_0 = scharrCorner<V>(V::load(row_2));
+  Vec row_2_shifts_2 = scharrCorner<V>(V::load(row_2 + 2));
+
+  SobelSums<V> sums;
+  if (withGx)
+  {
+    sums.gx_pos = V::adds(row_0_shifts_0, V::adds(row_2_shifts_0, scharrCenter<V>(V::load(row_1))));
+    sums.gx_neg = V::adds(row_0_shifts_2, V::adds(row_2_shifts_2, scharrCenter<V>(V::load(row_1 + 2))));
+  }
+
+  if (withGy)
+  {
+    sums.gy_pos = V::adds(row_0_shifts_0, V::adds(scharrCenter<V>(V::load(row_0 + 1)), row_0_shifts_2));
+    sums.gy_neg = V::adds(scharrCenter<V>(V::load(row_2 + 1)), V::adds(row_2_shifts_0, row_2_shifts_2));
+  }
+  return sums;
+}
+
+/**
+ * @brief Row kernel for sobelRingKernel calculating the 8-bit result of the Scharr operator into args.target.
+ */
+template<typename V, SobelDortmund::Direction dir> struct SobelScharrRow
+{
+  const SobelKernelArgs& args;
+
+  void operator()(const unsigned char* row_0, const unsigned char* row_1, const unsigned char* row_2, int x, int y, int columns) const
+  {
+    unsigned char* targetRow = args.target + (y - args.originY) * args.targetStride + x - args.originX;
+    for (int i = 0; i < columns; i += V::size)
+    {
+      const SobelSums<V> sums = scharrSums<V, dir != SobelDortmund::Vertical, dir != SobelDortmund::Horizontal>(row_0 + i, row_1 + i, row_2 + i);
+      storeResult<V>(targetRow + i, sobelMagnitude<V, dir>(sums), columns - i);
+    }
+  }
+};
+
+/**
+ * @brief Smooths 5 values with the binomial weights 1, 4, 6, 4, 1 divided by 16, split into 1/16, 1/4, 1/4 + 1/8, 1/4, 1/16.
+ * The result is at most 250.
+ */
+template<typename V> inline typename V::Vec binomial5(typename V::Vec a, typename V::Vec b, typename V::Vec c, typename V::Vec d, typename V::Vec e)
+{
+  typename V::Vec quarterC = V::div4(c);
+  return V::adds(V::adds(V::adds(V::div4(V::div4(a)), V::div4(V::div4(e))), V::adds(V::div4(b), V::div4(d))), V::adds(quarterC, V::div2(quarterC)));
+}
+
+/**
+ * @brief One side of the derivative 1, 2, 0, -2, -1, i.e. outer / 4 + inner / 2.
+ */
+template<typename V> inline typename V::Vec derivativeSide5(typename V::Vec outer, typename V::Vec inner)
+{
+  return V::adds(V::div4(outer), V::div2(inner));
+}
+
+/**
+ * @brief State of the 5x5 sobel operator, which is separated into the smoothing across and the derivative along each gradient. The rows of
+ * the ring are smoothed horizontally only once, when they enter it, and kept for the 5 rows they are part of.
+ */
+template<typename V> struct Sobel5x5State
+{
+  // The horizontally smoothed rows in the order of the ring of sobelRingKernel, column i belongs to column x + i of the strip
+  alignas(64) unsigned char smoothed[5][sobelStripWidth + V::size];
+  unsigned char* rows[5];
+
+  // The vertically smoothed row, with the 2 columns left and right of the strip
+  alignas(64) unsigned char column[sobelStripWidth + 4 + V::size];
+
+  // Strip and row whose smoothed rows are in the ring, a new strip starts with smoothing all 5 rows
+  int nextX;
+  int nextY;
+
+  Sobel5x5State() :
+    nextX(-1), nextY(-1)
+  {
+    for (int i = 0; i < 5; ++i)
+    {
+      rows[i] = smoothed[i];
+    }
+  }
+};
+
+/**
+ * @brief Row kernel for sobelRingKernel with a radius of 2 calculating the 8-bit result of the 5x5 sobel operator into args.target.
+ */
+template<typename V, SobelDortmund::Direction dir> struct Sobel5x5Row
+{
+  const SobelKernelArgs& args;
+  Sobel5x5State<V>* state;
+
+  void operator()(unsigned char* const* rows, int x, int y, int columns) const
+  {
+    const bool withGx = dir != SobelDortmund::Vertical;
+    const bool withGy = dir != SobelDortmund::Horizontal;
+    Sobel5x5State<V>& s = *state;
+
+    if (withGy)
+    {
+      // Continuing the strip only the new row has to be smoothed
+      int first = 0;
+      if (x == s.nextX && y == s.nextY)
+      {
+        unsigned char* top = s.rows[0];
+        for (int i = 0; i < 4; ++i)
+        {
+          s.rows[i] = s.rows[i + 1];
+        }
+        s.rows[4] = top;
+        first = 4;
+      }
+      for (int row = first; row < 5; ++row)
+      {
+        for (int i = 0; i < columns; i += V::size)
+        {
+          const unsigned char* p = rows[row] + i;
+          V::store(s.rows[row] + i, binomial5<V>(V::load(p), V::load(p + 1), V::load(p + 2), V::load(p + 3), V::load(p + 4)));
+        }
+      }
+      s.nextX = x;
+      s.nextY = y + 1;
+    }
+
+    if (withGx)
+    {
+      for (int i = 0; i < columns + 4; i += V::size)
+      {
+        V::store(s.column + i, binomial5<V>(V::load(rows[0] + i), V::load(rows[1] + i), V::load(rows[2] + i), V::load(rows[3] + i), V::load(rows[4] + i)));
+      }
+    }
+
+    unsigned char* targetRow = args.target + (y - args.originY) * args.targetStride + x - args.originX;
+    for (int i = 0; i < columns; i += V::size)
+    {
+      SobelSums<V> sums;
+      if (withGx)
+      {
+        sums.gx_pos = derivativeSide5<V>(V::load(s.column + i), V::load(s.column + i + 1));
+        sums.gx_neg = derivativeSide5<V>(V::load(s.column + i + 4), V::load(s.column + i + 3));
+      }
+      if (withGy)
+      {
+        sums.gy_pos = derivativeSide5<V>(V::load(s.rows[0] + i), V::load(s.rows[1] + i));
+        sums.gy_neg = derivativeSide5<V>(V::load(s.rows[4] + i), V::load(s.rows[3] + i));
+      }
+      storeResult<V>(targetRow + i, sobelMagnitude<V, dir>(sums), columns - i);
+    }
+  }
+};
+
+/**
+ * @brief Calculates the given gradient operator, Sobel5x5 needs the 5x5 surrounding of every pixel of args, i.e. 2 more rows and columns
+ * on each side.
+ * @param quarter Whether the kernel calculates the quarter image.
+ */
+template<typename V, bool quarter> void sobelOperatorKernel(const SobelKernelArgs& args, SobelDortmund::Operator op)
+{
+  switch (op)
+  {
+    case SobelDortmund::Scharr3x3:
+      sobelDirectionKernel<V, quarter, SobelScharrRow>(args);
+      break;
+    case SobelDortmund::Sobel5x5:
+    {
+      Sobel5x5State<V> state;
+      sobelDirectionKernel<V, quarter, Sobel5x5Row, 2>(args, &state);
+      break;
+    }
+    default:
+      sobelDirectionKernel<V, quarter, SobelMagnitudeRow>(args);
+      break;
+  }
+}
+
+/**
+ * @brief Calculates the given gradient operator on a YUV422 image using every Y value.
+ */
+template<typename V> void sobelOperatorFullKernel(const SobelKernelArgs& args, SobelDortmund::Operator op)
+{
+  sobelOperatorKernel<V, false>(args, op);
+}
+
+/**
+ * @brief Calculates the given gradient operator on a YUV422 image using every second Y value and every second row.
+ */
+template<typename V> void sobelOperatorQuarterKernel(const SobelKernelArgs& args, SobelDortmund::Operator op)
+{
+  sobelOperatorKernel<V, true>(args, op);
+}
+
+/**
+ * @brief Smooths 3 values with the binomial weights 1, 2, 1 divided by 4, split into 1/4, 1/2, 1/4. The result is at most 253.
+ */
+template<typename V> inline typename V::Vec binomial3(typename V::Vec a, typename V::Vec b, typename V::Vec c)
+{
+  return V::adds(V::adds(V::div4(a), V::div4(c)), V::div2(b));
+}
+
+/**
+ * @brief The separable gaussian of the given radius, i.e. the binomial weights of 2 * radius + 1 values. Provides vertical(rows, i), which
+ * smooths the values i of the 2 * radius + 1 rows, and horizontal(p), which smooths the values starting at p, both for V::size values.
+ */
+template<typename V, int radius> struct SobelGaussian;
+
+template<typename V> struct SobelGaussian<V, 1>
+{
+  static typename V::Vec vertical(unsigned char* const* rows, int i)
+  {
+    return binomial3<V>(V::load(rows[0] + i), V::load(rows[1] + i), V::load(rows[2] + i));
+  }
+  static typename V::Vec horizontal(const unsigned char* p) { return binomial3<V>(V::load(p), V::load(p + 1), V::load(p + 2)); }
+};
+
+template<typename V> struct SobelGaussian<V, 2>
+{
+  static typename V::Vec vertical(unsigned char* const* rows, int i)
+  {
+    return binomial5<V>(V::load(rows[0] + i), V::load(rows[1] + i), V::load(rows[2] + i), V::load(rows[3] + i), V::load(rows[4] + i));
+  }
+  static typename V::Vec horizontal(const unsigned char* p)
+  {
+    return binomial5<V>(V::load(p), V::load(p + 1), V::load(p + 2), V::load(p + 3), V::load(p + 4));
+  }
+};
+
+/**
+ * @brief Same as sobelRingKernel, but the Y values are smoothed with the gaussian of the given radius before the row kernel gets them.
+ * Every row of the image is extracted once into a ring of 2 * smoothRadius + 1 rows, which are smoothed vertically into a single row and that
+ * horizontally into the ring of 3 rows of the row kernel. So the smoothed image is never stored, only the rows of the current strip.
+ * @param smoothRadius 1 for the 3x3 and 2 for the 5x5 gaussian. The Y values of smoothRadius more rows and columns around the surrounding of
+ * the row kernel are read.
+ */
+template<typename V, typename Sampling, int smoothRadius, typename RowKernel>
+void sobelSmoothedRingKernel(const SobelKernelArgs& args, const RowKernel& rowKernel)
+{
+  const int rawRows = 2 * smoothRadius + 1;
+
+  // As in sobelRingKernel the stencils of the last iteration read up to V::size values behind the extracted ones
+  alignas(64) unsigned char raw[rawRows][sobelStripWidth + 2 + 2 * smoothRadius + V::size];
+  alignas(64) unsigned char vertical[sobelStripWidth + 2 + 2 * smoothRadius + V::size];
+  alignas(64) unsigned char ring[3][sobelStripWidth + 2 + V::size];
+
+  if (args.yBegin >= args.yEnd)
+  {
+    return;
+  }
+
+  for (int stripBegin = args.xBegin; stripBegin < args.xEnd; stripBegin += sobelStripWidth)
+  {
+    const int columns = args.xEnd - stripBegin < sobelStripWidth ? args.xEnd - stripBegin : sobelStripWidth;
+
+    // The smoothed values of the columns and the 3x3 surrounding, and the Y values needed for them
+    const int count = columns + 2;
+    const int rawCount = count + 2 * smoothRadius;
+
+    // The first row of the gaussian of the row above the first one to calculate
+    const unsigned char* source = args.image + (args.yBegin - 1 - smoothRadius) * args.rowStride +
+                                  Sampling::bytesPerColumn * (stripBegin - 1 - smoothRadius);
+    unsigned char* rawPointers[rawRows];
+    for (int i = 0; i < rawRows; ++i)
+    {
+      rawPointers[i] = raw[i];
+    }
+    for (int i = 0; i < rawRows - 1; ++i)
+    {
+      Sampling::extractRow(source + i * args.rowStride, args.rowStride, rawCount, rawPointers[i]);
+    }
+    unsigned char* rows[3] = { ring[0], ring[1], ring[2] };
+
+    // Smoothed row y is the lowest row of the surrounding of row y - 1
+    for (int y = args.yBegin - 1; y <= args.yEnd; ++y)
+    {
+      Sampling::extractRow(source + (rawRows - 1) * args.rowStride, args.rowStride, rawCount, rawPointers[rawRows - 1]);
+      source += args.rowStride;
+
+      for (int i = 0; i < rawCount; i += V::size)
+      {
+        V::store(vertical + i, SobelGaussian<V, smoothRadius>::vertical(rawPointers, i));
+      }
+      for (int i = 0; i < count; i += V::size)
+      {
+        V::store(rows[2] + i, SobelGaussian<V, smoothRadius>::horizontal(vertical + i));
+      }
+
+      unsigned char* top = rawPointers[0];
+      for (int i = 0; i < rawRows - 1; ++i)
+      {
+        rawPointers[i] = rawPointers[i + 1];
+      }
+      rawPointers[rawRows - 1] = top;
+
+      if (y > args.yBegin)
+      {
+        rowKernel(rows[0], rows[1], rows[2], stripBegin, y - 1, columns);
+      }
+      rotateRing(rows);
+    }
+  }
+}
+
+/**
+ * @brief Calls sobelSmoothedRingKernel with the sampling of args.format and args.quarterSampling.
+ * @param quarter Whether the kernel calculates the quarter image.
+ */
+template<typename V, bool quarter, int smoothRadius, typename RowKernel>
+void sobelSmoothedFormatKernel(const SobelKernelArgs& args, const RowKernel& rowKernel)
+{
+  if (quarter && args.quarterSampling == SobelDortmund::BoxAverage)
+  {
+    switch (args.format)
+    {
+      case SobelDortmund::UYVY:
+        sobelSmoothedRingKernel<V, SobelBoxSampling<V, SobelDortmund::UYVY>, smoothRadius>(args, rowKernel);
+        break;
+      case SobelDortmund::Y8:
+        sobelSmoothedRingKernel<V, SobelBoxSampling<V, SobelDortmund::Y8>, smoothRadius>(args, rowKernel);
+        break;
+      default:
+        sobelSmoothedRingKernel<V, SobelBoxSampling<V, SobelDortmund::YUYV>, smoothRadius>(args, rowKernel);
+        break;
+    }
+    return;
+  }
+
+  switch (args.format)
+  {
+    case SobelDortmund::UYVY:
+      sobelSmoothedRingKernel<V, SobelSampling<V, SobelDortmund::UYVY, quarter>, smoothRadius>(args, rowKernel);
+      break;
+    case SobelDortmund::Y8:
+      sobelSmoothedRingKernel<V, SobelSampling<V, SobelDortmund::Y8, quarter>, smoothRadius>(args, rowKernel);
+      break;
+    default:
+      sobelSmoothedRingKernel<V, SobelSampling<V, SobelDortmund::YUYV, quarter>, smoothRadius>(args, rowKernel);
+      break;
+  }
+}
+
+/**
+ * @brief Calls sobelSmoothedFormatKernel with SobelMagnitudeRow for the direction as compile time constant.
+ */
+template<typename V, bool quarter, int smoothRadius> void sobelSmoothedDirectionKernel(const SobelKernelArgs& args)
+{
+  switch (args.dir)
+  {
+    case SobelDortmund::Horizontal:
+    {
+      SobelMagnitudeRow<V, SobelDortmund::Horizontal> rowKernel = { args };
+      sobelSmoothedFormatKernel<V, quarter, smoothRadius>(args, rowKernel);
+      break;
+    }
+    case SobelDortmund::Vertical:
+    {
+      SobelMagnitudeRow<V, SobelDortmund::Vertical> rowKernel = { args };
+      sobelSmoothedFormatKernel<V, quarter, smoothRadius>(args, rowKernel);
+      break;
+    }
+    default:
+    {
+      SobelMagnitudeRow<V, SobelDortmund::Uni> rowKernel = { args };
+      sobelSmoothedFormatKernel<V, quarter, smoothRadius>(args, rowKernel);
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Calculates the sobel operator on the Y values smoothed with the given gaussian, which needs smoothRadius more rows and columns on each
+ * side of the 3x3 surrounding of every pixel of args. Without smoothing it is the same as sobelFullKernel or sobelQuarterKernel.
+ * @param quarter Whether the kernel calculates the quarter image.
+ */
+template<typename V, bool quarter> void sobelSmoothedKernel(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing)
+{
+  switch (smoothing)
+  {
+    case SobelDortmund::Gaussian3x3:
+      sobelSmoothedDirectionKernel<V, quarter, 1>(args);
+      break;
+    case SobelDortmund::Gaussian5x5:
+      sobelSmoothedDirectionKernel<V, quarter, 2>(args);
+      break;
+    default:
+      sobelDirectionKernel<V, quarter, SobelMagnitudeRow>(args);
+      break;
+  }
+}
+
+/**
+ * @brief Calculates the sobel operator on the smoothed Y values of a YUV422 image using every Y value.
+ */
+template<typename V> void sobelSmoothedFullKernel(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing)
+{
+  sobelSmoothedKernel<V, false>(args, smoothing);
+}
+
+/**
+ * @brief Calculates the sobel operator on the smoothed Y values of a YUV422 image using every second Y value and every second row.
+ */
+template<typename V> void sobelSmoothedQuarterKernel(const SobelKernelArgs& args, SobelDortmund::Smoothing smoothing)
+{
+  sobelSmoothedKernel<V, true>(args, smoothing);
+}
+
+/**
+ * @brief The vertical scanlines of sobelScanlineKernel. The result along scanline i is stored at args.target + i * args.targetStride, the value
+ * of row y at index y - args.originY.
+ */
+struct SobelScanlineArgs
+{
+  const int* columns;  ///< The column of every scanline.
+  int count;           ///< Number of scanlines.
+  int width;           ///< Width of the (full or quarter) image. Scanlines whose surrounding is not inside of it are skipped.
+};
+
+// Scanlines and rows gathered at once by sobelScanlineKernel, so the gathered columns stay in the L1 cache
+static const int sobelScanlineGroup = 16;
+static const int sobelScanlineBlockRows = 256;
+
+/**
+ * @brief Calculates the sobel operator along vertical scanlines for the rows args.yBegin to args.yEnd - 1. The Y values of every scanline and
+ * its left and right neighbor are gathered into three columns, reading every row of the image once for a group of scanlines. The operator then
+ * runs down the columns, V::size rows per step. A column is the transposed row, so sobelStep calculates it with gx and gy swapped, which gives
+ * exactly the same results as the row kernels.
+ * @param Sampling Reads the Y values of a row from the input image, see SobelSampling.
+ */
+template<typename V, typename Sampling, SobelDortmund::Direction dir>
+void sobelScanlineKernel(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines)
+{
+  const SobelDortmund::Direction transposed = dir == SobelDortmund::Horizontal ? SobelDortmund::Vertical
+                                            : dir == SobelDortmund::Vertical ? SobelDortmund::Horizontal : SobelDortmund::Uni;
+
+  // The left, center and right column of every scanline of a group, the last step reads up to V::size values behind the gathered ones
+  alignas(64) unsigned char gathered[sobelScanlineGroup][3][sobelScanlineBlockRows + 2 + V::size];
+
+  for (int group = 0; group < scanlines.count; group += sobelScanlineGroup)
+  {
+    // The scanlines of the group whose surrounding is inside the image and the offset of their left neighbor in a row
+    int indices[sobelScanlineGroup];
+    int offsets[sobelScanlineGroup];
+    int count = 0;
+    for (int i = group; i < scanlines.count && i < group + sobelScanlineGroup; ++i)
+    {
+      if (scanlines.columns[i] >= 1 && scanlines.columns[i] < scanlines.width - 1)
+      {
+        indices[count] = i;
+        offsets[count++] = Sampling::bytesPerColumn * (scanlines.columns[i] - 1);
+      }
+    }
+    const int rowStride = args.rowStride;
+
+    for (int blockBegin = args.yBegin; blockBegin < args.yEnd; blockBegin += sobelScanlineBlockRows)
+    {
+      const int rows = args.yEnd - blockBegin < sobelScanlineBlockRows ? args.yEnd - blockBegin : sobelScanlineBlockRows;
+
+      // The rows of the block and the one above and below it
+      const unsigned char* source = args.image + (blockBegin - 1) * rowStride;
+      for (int row = 0; row < rows + 2; ++row, source += rowStride)
+      {
+        for (int i = 0; i < count; ++i)
+        {
+          // A count of 1 takes the scalar fallback of extractRow, so each of these copies exactly one Y value
+          Sampling::extractRow(source + offsets[i], rowStride, 1, gathered[i][0] + row);
+          Sampling::extractRow(source + offsets[i] + Sampling::bytesPerColumn, rowStride, 1, gathered[i][1] + row);
+          Sampling::extractRow(source + offsets[i] + 2 * Sampling::bytesPerColumn, rowStride, 1, gathered[i][2] + row);
+        }
+      }
+
+      for (int i = 0; i < count; ++i)
+      {
+        unsigned char* target = args.target + indices[i] * args.targetStride + blockBegin - args.originY;
+        int y = 0;
+        for (; y + V::size <= rows; y += V::size)
+        {
+          V::store(target + y, sobelStep<V, transposed>(gathered[i][0] + y, gathered[i][1] + y, gathered[i][2] + y));
+        }
+        if (y < rows)
+        {
+          V::maskStore(target + y, sobelStep<V, transposed>(gathered[i][0] + y, gathered[i][1] + y, gathered[i][2] + y), rows - y);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Calls sobelScanlineKernel with the sampling of args.format and args.quarterSampling.
+ * @param quarter Whether the kernel calculates the quarter image.
+ */
+template<typename V, bool quarter, SobelDortmund::Direction dir>
+void sobelScanlineFormatKernel(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines)
+{
+  if (quarter && args.quarterSampling == SobelDortmund::BoxAverage)
+  {
+    switch (args.format)
+    {
+      case SobelDortmund::UYVY:
+        sobelScanlineKernel<V, SobelBoxSampling<V, SobelDortmund::UYVY>, dir>(args, scanlines);
+        break;
+      case SobelDortmund::Y8:
+        sobelScanlineKernel<V, SobelBoxSampling<V, SobelDortmund::Y8>, dir>(args, scanlines);
+        break;
+      default:
+        sobelScanlineKernel<V, SobelBoxSampling<V, SobelDortmund::YUYV>, dir>(args, scanlines);
+        break;
+    }
+    return;
+  }
+
+  switch (args.format)
+  {
+    case SobelDortmund::UYVY:
+      sobelScanlineKernel<V, SobelSampling<V, SobelDortmund::UYVY, quarter>, dir>(args, scanlines);
+      break;
+    case SobelDortmund::Y8:
+      sobelScanlineKernel<V, SobelSampling<V, SobelDortmund::Y8, quarter>, dir>(args, scanlines);
+      break;
+    default:
+      sobelScanlineKernel<V, SobelSampling<V, SobelDortmund::YUYV, quarter>, dir>(args, scanlines);
+      break;
+  }
+}
+
+/**
+ * @brief Calculates the sobel operator along the vertical scanlines, so the direction is a compile time constant in the inner loop.
+ * @param quarter Whether the kernel calculates the quarter image.
+ */
+template<typename V, bool quarter> void sobelScanlineDirectionKernel(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines)
+{
+  switch (args.dir)
+  {
+    case SobelDortmund::Horizontal:
+      sobelScanlineFormatKernel<V, quarter, SobelDortmund::Horizontal>(args, scanlines);
+      break;
+    case SobelDortmund::Vertical:
+      sobelScanlineFormatKernel<V, quarter, SobelDortmund::Vertical>(args, scanlines);
+      break;
+    default:
+      sobelScanlineFormatKernel<V, quarter, SobelDortmund::Uni>(args, scanlines);
+      break;
+  }
+}
+
+/**
+ * @brief Calculates the sobel operator along vertical scanlines of a YUV422 image using every Y value.
+ */
+template<typename V> void sobelScanlineFullKernel(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines)
+{
+  sobelScanlineDirectionKernel<V, false>(args, scanlines);
+}
+
+/**
+ * @brief Calculates the sobel operator along vertical scanlines of a YUV422 image using every second Y value and every second row.
+ */
+template<typename V> void sobelScanlineQuarterKernel(const SobelKernelArgs& args, const SobelScanlineArgs& scanlines)
+{
+  sobelScanlineDirectionKernel<V, true>(args, scanlines);
+}
+
+/**
+ * @brief A region of sobelBatchKernel and where its result is stored, in rows of endX - startX + 1 values.
+ */
+struct SobelBatchRegion
+{
+  int startX;
+  int startY;
+  int endX;
+  int endY;
+  unsigned char* target;
+};
+
+struct SobelBatchArgs
+{
+  const SobelBatchRegion* regions;  ///< The regions, ordered by startX.
+  int count;                        ///< Number of regions.
+  int width;                        ///< Width of the (full or quarter) image.
+  int height;                       ///< Height of the (full or quarter) image.
+};
+
+/**
+ * @brief Extracts the columns of row r needed by the regions near it into row + 1, i.e. the columns of the regions whose surrounding contains
+ * the row and the column left and right of them. The values left and right of the image are replicated.
+ * @param near Indices of the regions which might need the row, in ascending order.
+ */
+template<typename Sampling>
+void extractBatchRow(const SobelKernelArgs& args, const SobelBatchArgs& batch, const std::vector<int>& near, int r, unsigned char* row)
+{
+  const unsigned char* source = args.image + r * args.rowStride;
+  // The regions are ordered by startX, so the columns of overlapping or neighboring regions are extracted at once
+  int begin = 0;
+  int end = -2;
+  for (int i : near)
+  {
+    const SobelBatchRegion& region = batch.regions[i];
+    if (region.startY - 1 > r || region.endY + 1 < r)
+    {
+      continue;
+    }
+    const int regionBegin = region.startX > 0 ? region.startX - 1 : 0;
+    const int regionEnd = region.endX + 1 < batch.width ? region.endX + 1 : batch.width - 1;
+    if (regionBegin > end + 1)
+    {
+      if (begin <= end)
+      {
+        Sampling::extractRow(source + begin * Sampling::bytesPerColumn, args.rowStride, end - begin + 1, row + 1 + begin);
+      }
+      begin = regionBegin;
+      end = regionEnd;
+    }
+    else if (regionEnd > end)
+    {
+      end = regionEnd;
+    }
+  }
+  if (begin <= end)
+  {
+    Sampling::extractRow(source + begin * Sampling::bytesPerColumn, args.rowStride, end - begin + 1, row + 1 + begin);
+  }
+  row[0] = row[1];
+  row[batch.width + 1] = row[batch.width];
+}
+
+/**
+ * @brief Calculates the rows args.yBegin to args.yEnd - 1 of all regions of a batch in one sweep over the rows. Every row of the image is
+ * extracted once into a ring of 3 rows, only the columns needed by the regions around it, and the operator then runs over each region
+ * containing the row. So rows and columns shared by several regions are only read and extracted once. Rows and columns outside of the image
+ * are replicated, so every region gets the result of sobelRingKernel with SobelDortmund::BorderReplicate.
+ * @param Sampling Reads the Y values of a row from the input image, see SobelSampling.
+ */
+template<typename V, typename Sampling, SobelDortmund::Direction dir>
+void sobelBatchKernel(const SobelKernelArgs& args, const SobelBatchArgs& batch)
+{
+  // Kept between calls, so no memory is allocated once they are large enough
+  static thread_local std::vector<unsigned char> ring;
+  static thread_local std::vector<int> byStartY;
+  static thread_local std::vector<int> near;
+
+  // Every row has the value left and right of the image, the last step reads up to V::size values behind it
+  const int rowSize = batch.width + 2 + V::size;
+  if (ring.size() < 3u * rowSize)
+  {
+    ring.resize(3 * rowSize);
+  }
+  int ringRows[3] = { -1, -1, -1 };
+
+  // The regions which might need the rows around the current one are kept in near, so every row only looks at the regions around it
+  byStartY.resize(batch.count);
+  for (int i = 0; i < batch.count; ++i)
+  {
+    byStartY[i] = i;
+  }
+  std::sort(byStartY.begin(), byStartY.end(), [&batch](int a, int b) { return batch.regions[a].startY < batch.regions[b].startY; });
+  near.clear();
+  int next = 0;
+
+  for (int y = args.yBegin; y < args.yEnd; ++y)
+  {
+    for (; next < batch.count && batch.regions[byStartY[next]].startY - 2 <= y; ++next)
+    {
+      near.insert(std::upper_bound(near.begin(), near.end(), byStartY[next]), byStartY[next]);
+    }
+    near.erase(std::remove_if(near.begin(), near.end(), [&batch, y](int i) { return batch.regions[i].endY + 2 < y; }), near.end());
+
+    bool active = false;
+    for (int i : near)
+    {
+      active = active || (batch.regions[i].startY <= y && y <= batch.regions[i].endY);
+    }
+    if (!active)
+    {
+      continue;
+    }
+
+    // The row above, the row itself and the row below, each extracted when it is needed first
+    const unsigned char* rows[3];
+    for (int k = 0; k < 3; ++k)
+    {
+      const int r = y - 1 + k < 0 ? 0 : y - 1 + k >= batch.height ? batch.height - 1 : y - 1 + k;
+      unsigned char* row = ring.data() + (r % 3) * rowSize;
+      if (ringRows[r % 3] != r)
+      {
+        extractBatchRow<Sampling>(args, batch, near, r, row);
+        ringRows[r % 3] = r;
+      }
+      rows[k] = row;
+    }
+
+    for (int i : near)
+    {
+      const SobelBatchRegion& region = batch.regions[i];
+      if (y < region.startY || y > region.endY)
+      {
+        continue;
+      }
+      unsigned char* target = region.target + (y - region.startY) * (region.endX - region.startX + 1);
+      for (int x = region.startX; x <= region.endX; x += V::size)
+      {
+        storeResult<V>(target + x - region.startX, sobelStep<V, dir>(rows[0] + x, rows[1] + x, rows[2] + x), region.endX + 1 - x);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Calls sobelBatchKernel with the sampling of args.format and args.quarterSampling.
+ * @param quarter Whether the kernel calculates the quarter image.
+ */
+template<typename V, bool quarter, SobelDortmund::Direction dir>
+void sobelBatchFormatKernel(const SobelKernelArgs& args, const SobelBatchArgs& batch)
+{
+  if (quarter && args.quarterSampling == SobelDortmund::BoxAverage)
+  {
+    switch (args.format)
+    {
+      case SobelDortmund::UYVY:
+        sobelBatchKernel<V, SobelBoxSampling<V, SobelDortmund::UYVY>, dir>(args, batch);
+        break;
+      case SobelDortmund::Y8:
+        sobelBatchKernel<V, SobelBoxSampling<V, SobelDortmund::Y8>, dir>(args, batch);
+        break;
+      default:
+        sobelBatchKernel<V, SobelBoxSampling<V, SobelDortmund::YUYV>, dir>(args, batch);
+        break;
+    }
+    return;
+  }
+
+  switch (args.format)
+  {
+    case SobelDortmund::UYVY:
+      sobelBatchKernel<V, SobelSampling<V, SobelDortmund::UYVY, quarter>, dir>(args, batch);
+      break;
+    case SobelDortmund::Y8:
+      sobelBatchKernel<V, SobelSampling<V, SobelDortmund::Y8, quarter>, dir>(args, batch);
+      break;
+    default:
+      sobelBatchKernel<V, SobelSampling<V, SobelDortmund::YUYV, quarter>, dir>(args, batch);
+      break;
+  }
+}
+
+/**
+ * @brief Calculates the regions of a batch, so the direction is a compile time constant in the inner loop.
+ * @param quarter Whether the kernel calculates the quarter image.
+ */
+template<typename V, bool quarter> void sobelBatchDirectionKernel(const SobelKernelArgs& args, const SobelBatchArgs& batch)
+{
+  switch (args.dir)
+  {
+    case SobelDortmund::Horizontal:
+      sobelBatchFormatKernel<V, quarter, SobelDortmund::Horizontal>(args, batch);
+      break;
+    case SobelDortmund::Vertical:
+      sobelBatchFormatKernel<V, quarter, SobelDortmund::Vertical>(args, batch);
+      break;
+    default:
+      sobelBatchFormatKernel<V, quarter, SobelDortmund::Uni>(args, batch);
+      break;
+  }
+}
+
+/**
+ * @brief Calculates the regions of a batch of a YUV422 image using every Y value.
+ */
+template<typename V> void sobelBatchFullKernel(const SobelKernelArgs& args, const SobelBatchArgs& batch)
+{
+  sobelBatchDirectionKernel<V, false>(args, batch);
+}
+
+/**
+ * @brief Calculates the regions of a batch of a YUV422 image using every second Y value and every second row.
+ */
+template<typename V> void sobelBatchQuarterKernel(const SobelKernelArgs& args, const SobelBatchArgs& batch)
+{
+  sobelBatchDirectionKernel<V, true>(args, batch);
+}
@@ -0,0 +1,163 @@
+/**
+ * @file src/SobelSSSE3.h
+ *
+ * Declares the 128-bit SSSE3 instruction set traits for the sobel kernels in SobelKernel.h.
+ * This is the baseline that runs on every supported CPU including the robot's Atom.
+ *
+ * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
+ */
+
+#pragma once
+
+#include "SIMD.h"
+
+struct SobelSSSE3
+{
+  typedef __m128i Vec;
+
+  // Number of 8-bit values in one register
+  static const int size = 16;
+
+  /**
+   * @brief Extracts 16 consecutive Y values of a YUV422 row into one register.
+   * @param p Pointer to the first Y value, 32 bytes are read.
+   */
+  static Vec extractY(const unsigned char* p)
+  {
+    // Let the YUV422 array be: Y0, U0, Y1, V0, Y2, U1, Y3, V1, Y4, U2, Y5, V2, ...
+    // So the Y values are at the even bytes. _mm_shuffle_epi8 moves them into the lower 8 bytes of each load
+    // (-1 clears a byte) and the lower halves of both loads are then combined to Y0, Y1, ... , Y15
+    const __m128i evenBytes = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), evenBytes);
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)), evenBytes);
+    return _mm_unpacklo_epi64(a, b);
+  }
+
+  /**
+   * @brief Extracts every second of 32 consecutive Y values of a YUV422 row into one register.
+   * @param p Pointer to the first Y value, 64 bytes are read.
+   */
+  static Vec extractQuarterY(const unsigned char* p)
+  {
+    // The wanted Y values are every fourth byte, so each load gives 4 of them. Each load gets its own shuffle mask,
+    // which moves its values to a different 32-bit block, so the four results can just be combined with or.
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                                 _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)),
+                                 _mm_setr_epi8(-1, -1, -1, -1, 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1));
+    __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32)),
+                                 _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12, -1, -1, -1, -1));
+    __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48)),
+                                 _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12));
+    return _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+  }
+
+  /**
+   * @brief Same as extractY for a UYVY row (U0, Y0, V0, Y1, ...), where the Y values are at the odd bytes.
+   * @param p Pointer to the first U value, 32 bytes are read.
+   */
+  static Vec extractOddY(const unsigned char* p)
+  {
+    const __m128i oddBytes = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), oddBytes);
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)), oddBytes);
+    return _mm_unpacklo_epi64(a, b);
+  }
+
+  /**
+   * @brief Same as extractQuarterY for a UYVY row.
+   * @param p Pointer to the first U value, 64 bytes are read.
+   */
+  static Vec extractQuarterOddY(const unsigned char* p)
+  {
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                                 _mm_setr_epi8(1, 5, 9, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)),
+                                 _mm_setr_epi8(-1, -1, -1, -1, 1, 5, 9, 13, -1, -1, -1, -1, -1, -1, -1, -1));
+    __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32)),
+                                 _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 1, 5, 9, 13, -1, -1, -1, -1));
+    __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48)),
+                                 _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 5, 9, 13));
+    return _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+  }
+
+  /**
+   * @brief Extracts the U and V values of 16 pixel pairs of a YUV422 row into two registers.
+   * @param uOffset Byte of the U value in a pair, 1 for YUYV and 0 for UYVY. The V value is 2 bytes behind it.
+   * @param p Pointer to the first byte of the first pair, 64 bytes are read.
+   */
+  template<int uOffset> static void extractUV(const unsigned char* p, Vec& u, Vec& v)
+  {
+    // Each load holds 4 pairs, the shuffle gathers their 4 U values into the first and their 4 V values into the second 32-bit block.
+    // Interleaving the blocks of the 4 loads then gives U0, ... , U15 in the lower and V0, ... , V15 in the upper 64 bits of two registers.
+    const __m128i uv = _mm_setr_epi8(uOffset, uOffset + 4, uOffset + 8, uOffset + 12, uOffset + 2, uOffset + 6, uOffset + 10, uOffset + 14,
+                                     -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), uv);
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)), uv);
+    __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32)), uv);
+    __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48)), uv);
+    __m128i ab = _mm_unpacklo_epi32(a, b);
+    __m128i cd = _mm_unpacklo_epi32(c, d);
+    u = _mm_unpacklo_epi64(ab, cd);
+    v = _mm_unpackhi_epi64(ab, cd);
+  }
+
+  /**
+   * @brief Averages each 2x2 block of Y values with rounding. a0, a1 are 2 * 16 consecutive Y values of a row and b0, b1 those of the row below.
+   */
+  static Vec boxAverage(Vec a0, Vec a1, Vec b0, Vec b1)
+  {
+    // _mm_maddubs_epi16 with all factors 1 adds each pair of neighbouring values into a 16-bit value, so the sum of a block fits easily
+    const __m128i ones = _mm_set1_epi8(1);
+    const __m128i two = _mm_set1_epi16(2);
+    __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_maddubs_epi16(a0, ones), _mm_maddubs_epi16(b0, ones)), two), 2);
+    __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_maddubs_epi16(a1, ones), _mm_maddubs_epi16(b1, ones)), two), 2);
+    return _mm_packus_epi16(lo, hi);
+  }
+
+  // Divides each of the 8-bit values by 2 or 4
+  static Vec div2(Vec a) { return _mm_srli_epi8(a, 1); }
+  static Vec div4(Vec a) { return _mm_srli_epi8(a, 2); }
+
+  static Vec adds(Vec a, Vec b) { return _mm_adds_epu8(a, b); }
+  static Vec subs(Vec a, Vec b) { return _mm_subs_epu8(a, b); }
+  static Vec max(Vec a, Vec b) { return _mm_max_epu8(a, b); }
+  static Vec min(Vec a, Vec b) { return _mm_min_epu8(a, b); }
+
+  // Bitwise operations and comparison, cmpeq sets all bits of equal values. andNot(a, b) is ~a & b.
+  static Vec set1(char a) { return _mm_set1_epi8(a); }
+  static Vec cmpeq(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+  static Vec bitAnd(Vec a, Vec b) { return _mm_and_si128(a, b); }
+  static Vec bitOr(Vec a, Vec b) { return _mm_or_si128(a, b); }
+  static Vec bitXor(Vec a, Vec b) { return _mm_xor_si128(a, b); }
+  static Vec andNot(Vec a, Vec b) { return _mm_andnot_si128(a, b); }
+
+  // Bit i is the highest bit of value i
+  static unsigned movemask(Vec a) { return static_cast<unsigned>(_mm_movemask_epi8(a)); }
+
+  // Sum of the absolute differences of all values, _mm_sad_epu8 gives the sums of both halves in the low 16 bits of each 64-bit half
+  static unsigned sad(Vec a, Vec b)
+  {
+    __m128i sums = _mm_sad_epu8(a, b);
+    return static_cast<unsigned>(_mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4));
+  }
+
+  // 16-bit operations, each register holds 8 signed 16-bit values
+
+  // Loads 8 Y values and zero extends them to 16 bit
+  static Vec loadWide(const unsigned char* p) { return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), _mm_setzero_si128()); }
+  static Vec add16(Vec a, Vec b) { return _mm_add_epi16(a, b); }
+  static Vec sub16(Vec a, Vec b) { return _mm_sub_epi16(a, b); }
+
+  // Interleaves the first or the last 4 values of a and b
+  static Vec interleaveLo16(Vec a, Vec b) { return _mm_unpacklo_epi16(a, b); }
+  static Vec interleaveHi16(Vec a, Vec b) { return _mm_unpackhi_epi16(a, b); }
+
+  static Vec load(const unsigned char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+  static void store(unsigned char* p, Vec a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+
+  // Only for p aligned to 16 bytes, where the Atom does not pay for the unaligned access
+  static Vec loadAligned(const unsigned char* p) { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+  static void storeAligned(unsigned char* p, Vec a) { _mm_store_si128(reinterpret_cast<__m128i*>(p), a); }
+  static void maskStore(unsigned char* p, Vec a, int count) { _mm_maskstoreu_si128(p, a, count); }
+};
@@ -0,0 +1,31 @@
+/**
+ * @file src/SobelScalar.h
+ *
+ * Declares instruction set traits for the sobel kernels in SobelKernel.h, which calculate one pixel per iteration without any SIMD.
+ * They calculate exactly the same (saturated and pre-divided) results as the SIMD traits and are used for the few pixels at the image border.
+ *
+ * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
+ */
+
+#pragma once
+
+struct SobelScalar
+{
+  typedef unsigned char Vec;
+
+  // Number of 8-bit values in one register
+  static const int size = 1;
+
+  static Vec div2(Vec a) { return a >> 1; }
+  static Vec div4(Vec a) { return a >> 2; }
+
+  static Vec adds(Vec a, Vec b) { return a + b > 255 ? 255 : static_cast<Vec>(a + b); }
+  static Vec subs(Vec a, Vec b) { return a > b ? static_cast<Vec>(a - b) : 0; }
+  static Vec max(Vec a, Vec b) { return a > b ? a : b; }
+  static Vec min(Vec a, Vec b) { return a < b ? a : b; }
+
+  static Vec load(const unsigned char* p) { return *p; }
+  static void store(unsigned char* p, Vec a) { *p = a; }
+  static Vec loadAligned(const unsigned char* p) { return *p; }
+  static void storeAligned(unsigned char* p, Vec a) { *p = a; }
+};
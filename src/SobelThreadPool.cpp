@@ -0,0 +1,86 @@
+#include "SobelThreadPool.h"
+
+SobelThreadPool::SobelThreadPool(int threads) :
+  task(nullptr), context(nullptr), taskCount(0), nextTask(0), busyWorkers(0), generation(0), stop(false)
+{
+  for (int i = 1; i < threads; ++i)
+  {
+    workers.push_back(std::thread(&SobelThreadPool::work, this));
+  }
+}
+
+SobelThreadPool::~SobelThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  wake.notify_all();
+  for (size_t i = 0; i < workers.size(); ++i)
+  {
+    workers[i].join();
+  }
+}
+
+void SobelThreadPool::run(int tasks, void (*task)(void* context, int index), void* context)
+{
+  std::unique_lock<std::mutex> runLock(runMutex, std::try_to_lock);
+  if (!runLock.owns_lock() || workers.empty() || tasks < 2)
+  {
+    for (int i = 0; i < tasks; ++i)
+    {
+      task(context, i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->task = task;
+    this->context = context;
+    taskCount = tasks;
+    nextTask = 0;
+    busyWorkers = static_cast<int>(workers.size());
+    ++generation;
+  }
+  wake.notify_all();
+
+  runTasks();
+
+  // The workers might still be running their last task
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+void SobelThreadPool::work()
+{
+  unsigned lastGeneration = 0;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [this, lastGeneration] { return stop || generation != lastGeneration; });
+      if (stop)
+      {
+        return;
+      }
+      lastGeneration = generation;
+    }
+
+    runTasks();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--busyWorkers == 0)
+    {
+      done.notify_one();
+    }
+  }
+}
+
+void SobelThreadPool::runTasks()
+{
+  for (int i = nextTask++; i < taskCount; i = nextTask++)
+  {
+    task(context, i);
+  }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file src/SobelThreadPool.h
+ *
+ * Declares a persistent pool of worker threads, which is used to calculate the sobel operator on horizontal bands in parallel.
+ *
+ * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SobelThreadPool
+{
+ public:
+  /**
+   * @brief Starts the worker threads. They are kept alive and waiting until the pool is destroyed, so no threads are spawned per call.
+   * @param threads Number of threads including the calling one, so threads - 1 workers are started.
+   */
+  explicit SobelThreadPool(int threads);
+
+  /**
+   * @brief Stops and joins all worker threads.
+   */
+  ~SobelThreadPool();
+
+  /**
+   * @brief Returns the number of threads including the calling one.
+   */
+  int getThreadCount() const
+  {
+    return static_cast<int>(workers.size()) + 1;
+  }
+
+  /**
+   * @brief Runs task(context, i) for every 0 <= i < tasks and returns when all are done. The calling thread works on the tasks as well.
+   * If the pool is already busy with a call from another thread, all tasks are run by the calling thread.
+   * @param tasks Number of tasks.
+   * @param task Function called for each task index.
+   * @param context Passed to every call of task.
+   */
+  void run(int tasks, void (*task)(void* context, int index), void* context);
+
+ private:
+  void work();
+
+  // Claims and runs tasks of the current call until none are left
+  void runTasks();
+
+  std::vector<std::thread> workers;
+  std::mutex runMutex;  ///< Held while a call is running.
+  std::mutex mutex;     ///< Protects everything below.
+  std::condition_variable wake;
+  std::condition_variable done;
+  void (*task)(void* context, int index);
+  void* context;
+  int taskCount;
+  std::atomic<int> nextTask;
+  int busyWorkers;
+  unsigned generation;  ///< Increased for every call, so the workers know there is something new to do.
+  bool stop;
+};
@@ -0,0 +1,143 @@
+/**
+ * @file src/SobelVector.h
+ *
+ * Declares portable 128-bit instruction set traits for the sobel kernels in SobelKernel.h, written with the vector extensions of GCC and
+ * clang instead of intrinsics. They calculate exactly the same results as SobelSSSE3 and replace it as the baseline, if the library is
+ * compiled with SOBEL_PORTABLE, e.g. for ARM or for checking the kernels without any x86 instruction set.
+ *
+ * @author <A href=mailto:fabian.rensen@tu-dortmund.de>Fabian Rensen</A>
+ */
+
+#pragma once
+
+#include <cstring>
+
+struct SobelVector
+{
+  typedef unsigned char Vec __attribute__((vector_size(16)));
+
+  // The same register seen as 8 signed 16-bit values
+  typedef short Vec16 __attribute__((vector_size(16)));
+
+  // Number of 8-bit values in one register
+  static const int size = 16;
+
+  /**
+   * @brief Extracts 16 Y values of a row into one register, every step bytes starting at p.
+   * The compiler turns the loop into shuffles where the target has them.
+   */
+  template<int step> static Vec gather(const unsigned char* p)
+  {
+    Vec result = Vec();
+    for (int i = 0; i < size; ++i)
+    {
+      result[i] = p[step * i];
+    }
+    return result;
+  }
+
+  // See SobelSSSE3 for the layouts, the Odd versions take a pointer to the first U value of a UYVY row
+  static Vec extractY(const unsigned char* p) { return gather<2>(p); }
+  static Vec extractQuarterY(const unsigned char* p) { return gather<4>(p); }
+  static Vec extractOddY(const unsigned char* p) { return gather<2>(p + 1); }
+  static Vec extractQuarterOddY(const unsigned char* p) { return gather<4>(p + 1); }
+
+  // See SobelSSSE3::extractUV
+  template<int uOffset> static void extractUV(const unsigned char* p, Vec& u, Vec& v)
+  {
+    u = gather<4>(p + uOffset);
+    v = gather<4>(p + uOffset + 2);
+  }
+
+  /**
+   * @brief Averages each 2x2 block of Y values with rounding. a0, a1 are 2 * 16 consecutive Y values of a row and b0, b1 those of the row below.
+   */
+  static Vec boxAverage(Vec a0, Vec a1, Vec b0, Vec b1)
+  {
+    Vec result = Vec();
+    for (int i = 0; i < size / 2; ++i)
+    {
+      result[i] = static_cast<unsigned char>((a0[2 * i] + a0[2 * i + 1] + b0[2 * i] + b0[2 * i + 1] + 2) >> 2);
+      result[size / 2 + i] = static_cast<unsigned char>((a1[2 * i] + a1[2 * i + 1] + b1[2 * i] + b1[2 * i + 1] + 2) >> 2);
+    }
+    return result;
+  }
+
+  // Divides each of the 8-bit values by 2 or 4
+  static Vec div2(Vec a) { return a >> 1; }
+  static Vec div4(Vec a) { return a >> 2; }
+
+  // The comparisons give all bits set for true, so the saturation and the selection are done with masks
+  static Vec adds(Vec a, Vec b) { Vec sum = a + b; return sum | (Vec)(sum < a); }
+  static Vec subs(Vec a, Vec b) { return (a - b) & (Vec)(a > b); }
+  static Vec max(Vec a, Vec b) { Vec greater = (Vec)(a > b); return (a & greater) | (b & ~greater); }
+  static Vec min(Vec a, Vec b) { Vec less = (Vec)(a < b); return (a & less) | (b & ~less); }
+
+  // Bitwise operations and comparison, cmpeq sets all bits of equal values. andNot(a, b) is ~a & b.
+  static Vec set1(char a) { Vec result = Vec(); return result + static_cast<unsigned char>(a); }
+  static Vec cmpeq(Vec a, Vec b) { return (Vec)(a == b); }
+  static Vec bitAnd(Vec a, Vec b) { return a & b; }
+  static Vec bitOr(Vec a, Vec b) { return a | b; }
+  static Vec bitXor(Vec a, Vec b) { return a ^ b; }
+  static Vec andNot(Vec a, Vec b) { return ~a & b; }
+
+  // Bit i is the highest bit of value i
+  static unsigned movemask(Vec a)
+  {
+    unsigned mask = 0;
+    for (int i = 0; i < size; ++i)
+    {
+      mask |= static_cast<unsigned>(a[i] >> 7) << i;
+    }
+    return mask;
+  }
+
+  // Sum of the absolute differences of all values
+  static unsigned sad(Vec a, Vec b)
+  {
+    Vec difference = subs(a, b) | subs(b, a);
+    unsigned sum = 0;
+    for (int i = 0; i < size; ++i)
+    {
+      sum += difference[i];
+    }
+    return sum;
+  }
+
+  // 16-bit operations, each register holds 8 signed 16-bit values
+
+  // Loads 8 Y values and zero extends them to 16 bit
+  static Vec loadWide(const unsigned char* p)
+  {
+    Vec16 result = Vec16();
+    for (int i = 0; i < size / 2; ++i)
+    {
+      result[i] = p[i];
+    }
+    return (Vec)result;
+  }
+  static Vec add16(Vec a, Vec b) { return (Vec)((Vec16)a + (Vec16)b); }
+  static Vec sub16(Vec a, Vec b) { return (Vec)((Vec16)a - (Vec16)b); }
+
+  // Interleaves the first or the last 4 values of a and b
+  static Vec interleaveLo16(Vec a, Vec b) { return interleave16(a, b, 0); }
+  static Vec interleaveHi16(Vec a, Vec b) { return interleave16(a, b, size / 4); }
+
+  static Vec interleave16(Vec a, Vec b, int first)
+  {
+    Vec16 a16 = (Vec16)a, b16 = (Vec16)b, result = Vec16();
+    for (int i = 0; i < size / 4; ++i)
+    {
+      result[2 * i] = a16[first + i];
+      result[2 * i + 1] = b16[first + i];
+    }
+    return (Vec)result;
+  }
+
+  // memcpy is the portable unaligned access, the compiler turns it into a single load or store
+  static Vec load(const unsigned char* p) { Vec a; std::memcpy(&a, p, size); return a; }
+  static void store(unsigned char* p, Vec a) { std::memcpy(p, &a, size); }
+  static Vec loadAligned(const unsigned char* p) { Vec a; std::memcpy(&a, __builtin_assume_aligned(p, size), size); return a; }
+  static void storeAligned(unsigned char* p, Vec a) { std::memcpy(__builtin_assume_aligned(p, size), &a, size); }
+  static void maskStore(unsigned char* p, Vec a, int count) { std::memcpy(p, &a, count); }
+};